@@ -0,0 +1,133 @@
+/**
+ * Measures how fast N threads can enqueue messages into librdkafka for the different
+ * producer topologies:
+ *
+ *  shared     - all threads produce through one producer
+ *  per_thread - every thread has its own producer
+ *  sharded    - messages are spread over a fixed number of producers by partition
+ *
+ * The brokers do not need to be reachable: messages pile up in the local queues, so this
+ * measures the cost of produce() itself (including the contention on the producer's
+ * internal queue locks), not the network. Queues are purged at the end of every run.
+ *
+ * Usage: producerapp [threads] [messages per thread] [shard count] [bootstrap servers]
+ **/
+#include <librdkafka/rdkafkacpp.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static const string TOPIC = "flycatcher-benchmark";
+static const int32_t PARTITIONS = 64;
+
+RdKafka::Producer *create_producer(const string &bootstrap_servers)
+{
+    string errstr;
+    unique_ptr<RdKafka::Conf> conf(RdKafka::Conf::create(RdKafka::Conf::CONF_GLOBAL));
+    conf->set("bootstrap.servers", bootstrap_servers, errstr);
+    conf->set("queue.buffering.max.messages", "10000000", errstr);
+    conf->set("queue.buffering.max.kbytes", "2097151", errstr);
+    conf->set("log_level", "0", errstr);
+
+    RdKafka::Producer *producer = RdKafka::Producer::create(conf.get(), errstr);
+    if (!producer)
+    {
+        cerr << "Failed to create producer: " << errstr << endl;
+        exit(1);
+    }
+    return producer;
+}
+
+/**
+ * Run one benchmark. Thread t produces through producers[select(t, partition)].
+ **/
+template <typename Select>
+double run(const string &label, vector<RdKafka::Producer *> &producers, unsigned int threads, unsigned int messages, Select select)
+{
+    const string payload(200, 'x');
+    atomic<size_t> failed = 0;
+    vector<thread> workers;
+
+    auto start = chrono::steady_clock::now();
+    for (unsigned int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t]()
+                             {
+            for (unsigned int i = 0; i < messages; ++i)
+            {
+                int32_t partition = (t * messages + i) % PARTITIONS;
+                RdKafka::Producer *producer = producers[select(t, partition)];
+                RdKafka::ErrorCode err = producer->produce(TOPIC, partition, RdKafka::Producer::RK_MSG_COPY,
+                                                           const_cast<char *>(payload.data()), payload.size(),
+                                                           nullptr, 0, 0, nullptr);
+                if (err != RdKafka::ERR_NO_ERROR)
+                {
+                    failed.fetch_add(1, memory_order_relaxed);
+                }
+            } });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    for (RdKafka::Producer *producer : producers)
+    {
+        producer->purge(RdKafka::Producer::PURGE_QUEUE | RdKafka::Producer::PURGE_INFLIGHT);
+        producer->poll(0);
+    }
+
+    double rate = (static_cast<double>(threads) * messages - failed.load()) / seconds;
+    cout << label << ": " << producers.size() << " producer(s), " << threads << " threads, "
+         << static_cast<size_t>(rate) << " msg/s";
+    if (failed.load() > 0)
+    {
+        cout << " (" << failed.load() << " failed)";
+    }
+    cout << endl;
+    return rate;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int threads = argc > 1 ? stoul(argv[1]) : 16;
+    unsigned int messages = argc > 2 ? stoul(argv[2]) : 200000;
+    unsigned int shards = argc > 3 ? stoul(argv[3]) : 4;
+    string bootstrap_servers = argc > 4 ? argv[4] : "127.0.0.1:1";
+
+    vector<RdKafka::Producer *> shared = {create_producer(bootstrap_servers)};
+    run("shared    ", shared, threads, messages, [](unsigned int, int32_t)
+        { return 0; });
+
+    vector<RdKafka::Producer *> per_thread;
+    for (unsigned int t = 0; t < threads; ++t)
+    {
+        per_thread.push_back(create_producer(bootstrap_servers));
+    }
+    run("per_thread", per_thread, threads, messages, [](unsigned int t, int32_t)
+        { return t; });
+
+    vector<RdKafka::Producer *> sharded;
+    for (unsigned int s = 0; s < shards; ++s)
+    {
+        sharded.push_back(create_producer(bootstrap_servers));
+    }
+    run("sharded   ", sharded, threads, messages, [shards](unsigned int, int32_t partition)
+        { return partition % shards; });
+
+    for (auto *producers : {&shared, &per_thread, &sharded})
+    {
+        for (RdKafka::Producer *producer : *producers)
+        {
+            delete producer;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+/**
+ * Compares the cost of the log timestamps:
+ *
+ *  sprintf  - the previous implementation: gmtime_r() and sprintf("%09.6f") for every line
+ *  cached   - Logging::timestamp(), reformatting only the microseconds within a second
+ *  append   - Logging::append_timestamp() into a reused buffer, as create_log() does
+ *
+ * Every variant runs on the given number of threads at once, each formatting
+ * [iterations] timestamps.
+ *
+ * Usage: timestampapp [threads] [iterations]
+ **/
+#include "logging/Logging.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Logging::timestamp() before the cache
+ **/
+string sprintf_timestamp()
+{
+    chrono::system_clock::time_point tp = chrono::system_clock::now();
+    time_t tt = chrono::system_clock::to_time_t(tp);
+    tm gmt{};
+    gmtime_r(&tt, &gmt);
+    chrono::duration<double> fractional_seconds = (tp - chrono::system_clock::from_time_t(tt)) + chrono::seconds(gmt.tm_sec);
+
+    string buffer("year/mo/dy hr:mn:sc.xxxxxx");
+    sprintf(&buffer.front(), "%04d/%02d/%02d %02d:%02d:%09.6f", gmt.tm_year + 1900, gmt.tm_mon + 1, gmt.tm_mday, gmt.tm_hour, gmt.tm_min, fractional_seconds.count());
+    return buffer;
+}
+
+template <typename Format>
+void run(const string &label, unsigned int threads, unsigned int iterations, Format format)
+{
+    vector<thread> workers;
+    vector<size_t> checksums(threads, 0);
+
+    auto start = chrono::steady_clock::now();
+    for (unsigned int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t]()
+                             {
+                                 string buffer;
+                                 for (unsigned int i = 0; i < iterations; ++i)
+                                 {
+                                     checksums[t] += format(buffer);
+                                 } });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    size_t total = static_cast<size_t>(threads) * iterations;
+    cout << label << ": " << total / seconds / 1e6 << "M timestamps/s, " << seconds * 1e9 / iterations << " ns per timestamp and thread" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int threads = argc > 1 ? stoul(argv[1]) : 4;
+    unsigned int iterations = argc > 2 ? stoul(argv[2]) : 2000000;
+
+    cout << "sprintf: " << sprintf_timestamp() << endl;
+    cout << "cached:  " << Logging::timestamp() << endl;
+    cout << threads << " thread(s), " << iterations << " timestamps each" << endl;
+
+    run("sprintf", threads, iterations, [](string &)
+        { return sprintf_timestamp().size(); });
+    run("cached ", threads, iterations, [](string &)
+        { return Logging::timestamp().size(); });
+    run("append ", threads, iterations, [](string &buffer)
+        {
+            buffer.clear();
+            Logging::append_timestamp(buffer);
+            return buffer.size(); });
+    return 0;
+}
@@ -1,14 +1,20 @@
 #include "AbstractPoller.h"
+#include "metrics/Metrics.h"
+
+static Metrics::Counter &files_queued_total = Metrics::Registry::instance().counter("flycatcher_files_queued_total", "Files found by the poller and queued for processing");
 
 AbstractPoller::AbstractPoller(std::string name, std::shared_ptr<SignalChannel> sig_channel) : AbstractWorker(name, sig_channel)
 {
 }
 
+void AbstractPoller::set_lanes(std::vector<SafeQueue<PollResult> *> lanes) { m_lanes = lanes; }
+
 void AbstractPoller::step()
 {
   PollResult r = poll();
   if (!r.empty())
   {
     m_queue->enqueue(r);
+    files_queued_total.inc();
   }
 }
@@ -3,6 +3,7 @@
 
 #include "AbstractWorker.h"
 #include "impl/PollResult.h"
+#include <vector>
 
 class AbstractPoller : public AbstractWorker
 {
@@ -15,6 +16,14 @@ public:
   AbstractPoller(std::string name, std::shared_ptr<SignalChannel> sig_channel);
   virtual ~AbstractPoller(){};
   virtual AbstractPoller *clone() const = 0;
+
+  // Whether the results must go to one queue per processor instead of the shared one
+  virtual bool pinned() const { return false; }
+  void set_lanes(std::vector<SafeQueue<PollResult> *> lanes_);
+
+protected:
+  // One queue per processor, set by the Connector for pinned pollers
+  std::vector<SafeQueue<PollResult> *> m_lanes;
 };
 
 #endif
@@ -14,6 +14,10 @@ void AbstractProcessor::step()
   {
     handle(d);
   }
+  else
+  {
+    idle();
+  }
 }
 
 AbstractProcessor::~AbstractProcessor()
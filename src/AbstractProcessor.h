@@ -6,9 +6,6 @@
 #include <transformers/AbstractTransformer.h>
 #include <string>
 #include <memory>
-#include <atomic>
-#include <condition_variable>
-#include <mutex>
 
 class AbstractProcessor : public AbstractWorker
 {
@@ -16,6 +13,8 @@ private:
   void step() override;
   virtual void clean() = 0;
   virtual void handle(PollResult d) = 0;
+  // Called when nothing was queued for a second
+  virtual void idle() {}
 
 public:
   AbstractProcessor(std::string name, std::shared_ptr<SignalChannel> sig_channel);
@@ -24,9 +23,6 @@ public:
 
 protected:
   std::vector<std::unique_ptr<AbstractTransformer>> *m_transformers;
-  std::atomic<size_t> *m_active_processors;
-  std::condition_variable *m_log_cv;
-  std::mutex *m_log_cv_mutex;
 };
 
 #endif
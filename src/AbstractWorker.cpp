@@ -1,10 +1,12 @@
 #include "AbstractWorker.h"
 #include "logging/Logging.h"
+#include "trace/Trace.h"
 
 void AbstractWorker::set_queue(SafeQueue<PollResult> *queue) { m_queue = queue; }
 
 void AbstractWorker::run()
 {
+  Trace::set_thread_name(m_name);
   while (!m_sig_channel->m_shutdown_requested.load())
   {
     {
@@ -17,9 +17,9 @@ public:
 protected:
   SafeQueue<PollResult> *m_queue;
   const std::string m_name;
+  std::shared_ptr<SignalChannel> m_sig_channel;
 
 private:
-  std::shared_ptr<SignalChannel> m_sig_channel;
   virtual void step() = 0;
   virtual void clean() = 0;
 };
@@ -1,6 +1,7 @@
 #include "Connector.h"
 #include "logging/Logging.h"
 #include "Version.h"
+#include "metrics/Metrics.h"
 #include <iostream>
 
 static std::string name = "Connector";
@@ -10,10 +11,33 @@ Connector::Connector(const PollerBridge &poller_,
     : m_poller(poller_), m_processors(processors_)
 {
   m_poller.set_queue(&m_queue);
-  for (auto &processor : m_processors)
+  if (m_poller.pinned())
+  {
+    // The poller picks the processor of each result, e.g. to keep the batches of a connection in order
+    std::vector<SafeQueue<PollResult> *> lanes;
+    for (auto &processor : m_processors)
+    {
+      m_lanes.push_back(std::make_unique<SafeQueue<PollResult>>());
+      lanes.push_back(m_lanes.back().get());
+      processor.set_queue(lanes.back());
+    }
+    m_poller.set_lanes(lanes);
+  }
+  else
   {
-    processor.set_queue(&m_queue);
+    for (auto &processor : m_processors)
+    {
+      processor.set_queue(&m_queue);
+    }
   }
+
+  Metrics::Registry::instance().gauge("flycatcher_file_queue_length", "Files queued for the processors", [this]()
+                                      { size_t queued = m_queue.size();
+                                        for (auto &lane : m_lanes)
+                                        {
+                                          queued += lane->size();
+                                        }
+                                        return static_cast<double>(queued); });
 }
 
 bool Connector::start()
@@ -5,6 +5,8 @@
 #include "ProcessorBridge.h"
 #include "SafeQueue.h"
 #include "impl/PollResult.h"
+#include <memory>
+#include <vector>
 
 class Connector
 {
@@ -17,6 +19,8 @@ private:
   PollerBridge m_poller;
   std::vector<ProcessorBridge> m_processors;
   SafeQueue<PollResult> m_queue;
+  // Queues of the processors, used instead of m_queue for pinned pollers
+  std::vector<std::unique_ptr<SafeQueue<PollResult>>> m_lanes;
 };
 
 #endif
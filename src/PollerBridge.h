@@ -15,6 +15,8 @@ public:
   PollerBridge(const PollerBridge &original);
   PollerBridge(const AbstractPoller &innerReader);
   inline void set_queue(SafeQueue<PollResult> *queue);
+  inline bool pinned() const;
+  inline void set_lanes(std::vector<SafeQueue<PollResult> *> lanes);
   bool start();
   void join() const;
   PollerBridge &operator=(const PollerBridge &original);
@@ -29,4 +31,14 @@ inline void PollerBridge::set_queue(SafeQueue<PollResult> *queue)
 {
   return m_poller_ptr->set_queue(queue);
 }
+
+inline bool PollerBridge::pinned() const
+{
+  return m_poller_ptr->pinned();
+}
+
+inline void PollerBridge::set_lanes(std::vector<SafeQueue<PollResult> *> lanes)
+{
+  return m_poller_ptr->set_lanes(lanes);
+}
 #endif
@@ -7,18 +7,79 @@
 #include "transformers/DecoratorPrepend.h"
 #include "transformers/DecoratorSet.h"
 #include "impl/SchemaRegistry.h"
+#include "impl/SchemaIdCache.h"
+#include <algorithm>
 #include <numeric> // for accumulate()
+#include <limits>
+#include <unordered_set>
+#include <sys/stat.h>
+#include <filesystem>
 #include <avro/Schema.hh>
 #include <avro/Compiler.hh>
 #include <cpprest/http_client.h>
 
 static std::string name = "ConfigParser";
 
+/**
+ * Collect the columns referenced by a 'transforms' list.
+ */
+static void collect_transform_columns(const YAML::Node &transforms, std::set<std::string> &columns)
+{
+    if (!transforms)
+    {
+        return;
+    }
+
+    for (const auto &d : transforms)
+    {
+        if (d["column"])
+        {
+            columns.emplace(d["column"].as<std::string>());
+        }
+
+        if (d["from_column"])
+        {
+            columns.emplace(d["from_column"].as<std::string>());
+        }
+    }
+}
+
+/**
+ * Collect the columns referenced by a (possibly nested) filter predicate.
+ */
+static void collect_predicate_columns(const YAML::Node &node, std::set<std::string> &columns)
+{
+    if (node.Type() != YAML::NodeType::Map)
+    {
+        return;
+    }
+
+    if (node["column"])
+    {
+        columns.emplace(node["column"].as<std::string>());
+    }
+
+    for (const std::string op : {"and", "or"})
+    {
+        if (node[op])
+        {
+            for (const auto &operand : node[op])
+            {
+                collect_predicate_columns(operand, columns);
+            }
+        }
+    }
+}
+
 ConfigParser::ConfigParser(std::string config_file) : m_config_file(config_file)
 {
     m_config = YAML::LoadFile(m_config_file);
 }
 
+ConfigParser::ConfigParser(std::string config_file, YAML::Node config) : m_config_file(config_file), m_config(config)
+{
+}
+
 ConfigParser &ConfigParser::instance(std::string c)
 {
     static ConfigParser i(c);
@@ -92,6 +153,60 @@ std::map<std::string, std::string> ConfigParser::kafka()
     return config_for_key("kafka");
 }
 
+std::map<std::string, std::string> ConfigParser::producer()
+{
+    if (has_key("producer"))
+    {
+        return config_for_key("producer");
+    }
+    return {};
+}
+
+std::map<std::string, std::string> ConfigParser::sink()
+{
+    if (has_key("sink"))
+    {
+        return config_for_key("sink");
+    }
+    return {};
+}
+
+std::map<std::string, std::string> ConfigParser::metrics()
+{
+    if (has_key("metrics"))
+    {
+        return config_for_key("metrics");
+    }
+    return {};
+}
+
+std::map<std::string, std::string> ConfigParser::trace()
+{
+    if (has_key("trace"))
+    {
+        return config_for_key("trace");
+    }
+    return {};
+}
+
+std::map<std::string, std::string> ConfigParser::stream()
+{
+    if (has_key("stream"))
+    {
+        return config_for_key("stream");
+    }
+    return {};
+}
+
+std::map<std::string, std::string> ConfigParser::socket()
+{
+    if (has_key("socket"))
+    {
+        return config_for_key("socket");
+    }
+    return {};
+}
+
 std::map<std::string, SchemaConfig> ConfigParser::schema_configs()
 {
     std::vector<std::string> err;
@@ -273,21 +388,111 @@ int32_t ConfigParser::fetch_schema_id(const std::string &name)
     return SchemaRegistry::instance().fetch_value_schema_id(name);
 }
 
-std::map<std::string, SchemaConfig> ConfigParser::schemas()
+std::map<std::string, SchemaConfig> ConfigParser::schemas(SchemaIdCache *cache, bool resolve_ids)
 {
-    std::map<std::string, SchemaConfig> schemas = schema_configs();
+    std::map<std::string, std::string> kafka_config = kafka();
+    int attempts = 5;
+    int backoff_ms = 500;
+    if (kafka_config.find("schema.registry.attempts") != kafka_config.end())
+    {
+        attempts = std::max(1, std::stoi(kafka_config["schema.registry.attempts"]));
+    }
+    if (kafka_config.find("schema.registry.backoff.ms") != kafka_config.end())
+    {
+        backoff_ms = std::max(1, std::stoi(kafka_config["schema.registry.backoff.ms"]));
+    }
 
-    for (auto &[topic, schema_config] : schemas)
+    std::vector<std::string> err;
+    std::map<std::string, SchemaConfig> schemas;
+    std::vector<SchemaIdCache::Entry> cached;
+    std::map<std::string, std::string> topic_for_subject;
+
+    // Resolve every schema id here, so that processor threads never talk to the registry
+    for (const auto &[topic, partial] : schema_configs())
     {
-        int schema_id = fetch_schema_id(topic);
-        schema_config.schema_id = schema_id;
-        schema_config.schema = assemble_schema(schema_config);
-        Logging::DEBUG("Created schema\n" + schema_config.schema.toJson() + "\n for topic '" + topic + "'", name);
+        avro::ValidSchema schema = assemble_schema(partial);
+        LOG_DEBUG("Created schema\n" + schema.toJson() + "\n for topic '" + topic + "'", name);
+
+        int32_t schema_id = -1;
+        SchemaIdCache::Entry entry{topic + "-value", SchemaIdCache::fingerprint(schema), schema.toJson(), std::make_shared<std::atomic<int32_t>>(-1)};
+        if (!resolve_ids)
+        {
+            // Sinks embedding the schema itself (e.g. Avro files) don't need an id
+        }
+        else if (cache && (schema_id = cache->lookup(entry.subject, entry.fingerprint)) != -1)
+        {
+            Logging::INFO("Using cached schema id " + std::to_string(schema_id) + " for topic '" + topic + "'", name);
+            cached.push_back(entry);
+            topic_for_subject[entry.subject] = topic;
+        }
+        else
+        {
+            schema_id = SchemaRegistry::instance().resolve_value_schema(topic, entry.schema_def, attempts, backoff_ms);
+            if (schema_id == -1)
+            {
+                err.emplace_back("Unable to resolve schema id for topic '" + topic + "' after " + std::to_string(attempts) + " attempt(s)");
+            }
+            else if (cache)
+            {
+                cache->store(entry.subject, entry.fingerprint, schema_id);
+            }
+        }
+
+        entry.id->store(schema_id);
+        schemas.insert(std::make_pair(topic, SchemaConfig{partial.name, partial.key_column, partial.columns, partial.column_map, partial.column_type_transforms, schema, entry.id}));
+    }
+
+    if (!err.empty())
+    {
+        std::string errstr = std::accumulate(err.begin(), err.end(), std::string(), [](std::string running_str, const std::string &new_str)
+                                             { return running_str.empty() ? new_str : running_str + "\n" + new_str; });
+        Logging::ERROR(errstr, name);
+        kill(getpid(), SIGINT);
+    }
+    else if (cache && resolve_ids)
+    {
+        cache->save();
+
+        // Verify the cached ids in the background; a single attempt each, this is not on the startup path
+        cache->refresh_async(cached, [topic_for_subject, backoff_ms](const SchemaIdCache::Entry &entry)
+                             { return SchemaRegistry::instance().resolve_value_schema(topic_for_subject.at(entry.subject), entry.schema_def, 1, backoff_ms); });
     }
 
     return schemas;
 }
 
+/**
+ * Reads the file again rather than using the parsed configuration, so that the level can be
+ * changed while running (see SIGHUP in main).
+ */
+std::string ConfigParser::log_level()
+{
+    YAML::Node config = YAML::LoadFile(m_config_file);
+    if (config["log_level"])
+    {
+        return config["log_level"].as<std::string>();
+    }
+    return "info";
+}
+
+size_t ConfigParser::log_queue_bytes()
+{
+    if (has_key("log_queue_bytes"))
+    {
+        return m_config["log_queue_bytes"].as<size_t>();
+    }
+    return 0;
+}
+
+std::string ConfigParser::report_file()
+{
+    if (has_key("report_file"))
+    {
+        return m_config["report_file"].as<std::string>();
+    }
+    return "";
+}
+
 std::pair<std::string, int> ConfigParser::max_age()
 {
     if (has_key("max_age"))
@@ -295,7 +500,20 @@ std::pair<std::string, int> ConfigParser::max_age()
         std::map<std::string, std::string> max_age_config = config_for_key("max_age");
         if (max_age_config.find("column") != max_age_config.end() && max_age_config.find("days") != max_age_config.end())
         {
-            return std::make_pair(max_age_config.find("column")->second, atoi(max_age_config.find("days")->second.c_str()));
+            /*
+            The configured column is the Avro field name (after column_map). The filter runs on the
+            raw CSV row before any transformation, so resolve it back to the CSV column here.
+            */
+            std::string column = max_age_config.find("column")->second;
+            for (const auto &[csv_column, field_name] : column_map())
+            {
+                if (!field_name.compare(column))
+                {
+                    column.assign(csv_column);
+                    break;
+                }
+            }
+            return std::make_pair(column, atoi(max_age_config.find("days")->second.c_str()));
         }
         else
         {
@@ -307,12 +525,20 @@ std::pair<std::string, int> ConfigParser::max_age()
 }
 
 std::vector<std::unique_ptr<AbstractTransformer>> ConfigParser::transformers()
+{
+    return create_transformers(m_config["transforms"]);
+}
+
+/**
+ * Chain the transformers of a 'transforms' list, e.g. of the configuration or of a route.
+ */
+std::vector<std::unique_ptr<AbstractTransformer>> ConfigParser::create_transformers(const YAML::Node &transforms)
 {
     std::vector<std::unique_ptr<AbstractTransformer>> transformers;
-    if (m_config["transforms"])
+    if (transforms)
     {
         std::unique_ptr<AbstractTransformer> last_ptr;
-        for (const auto &d : m_config["transforms"])
+        for (const auto &d : transforms)
         {
             std::string column = d["column"].as<std::string>();
             std::string type = d["type"].as<std::string>();
@@ -364,4 +590,357 @@ std::vector<std::unique_ptr<AbstractTransformer>> ConfigParser::transformers()
     return transformers;
 }
 
+std::unique_ptr<Predicate> ConfigParser::compile_predicate(const YAML::Node &node, const std::string &filter_name, std::vector<std::string> &err)
+{
+    if (node.Type() != YAML::NodeType::Map)
+    {
+        err.emplace_back("Predicate of filter '" + filter_name + "' should be of type map!");
+        return nullptr;
+    }
+
+    // Combinators: and/or over a list of nested predicates
+    for (const std::string op : {"and", "or"})
+    {
+        if (node[op])
+        {
+            std::vector<std::unique_ptr<Predicate>> operands;
+            for (const auto &operand : node[op])
+            {
+                std::unique_ptr<Predicate> ptr = compile_predicate(operand, filter_name, err);
+                if (ptr)
+                {
+                    operands.push_back(std::move(ptr));
+                }
+            }
+
+            if (operands.empty())
+            {
+                err.emplace_back("Empty '" + op + "' in filter '" + filter_name + "'");
+                return nullptr;
+            }
+
+            if (!op.compare("and"))
+            {
+                return std::make_unique<PredicateAnd>(std::move(operands));
+            }
+            return std::make_unique<PredicateOr>(std::move(operands));
+        }
+    }
+
+    if (!node["column"])
+    {
+        err.emplace_back("Missing column for predicate in filter '" + filter_name + "'");
+        return nullptr;
+    }
+
+    std::string column = node["column"].as<std::string>();
+    try
+    {
+        if (node["equals"])
+        {
+            return std::make_unique<PredicateEquals>(column, node["equals"].as<std::string>());
+        }
+        else if (node["in"])
+        {
+            std::unordered_set<std::string> values;
+            for (const auto &value : node["in"])
+            {
+                values.emplace(value.as<std::string>());
+            }
+            return std::make_unique<PredicateIn>(column, std::move(values));
+        }
+        else if (node["regex"])
+        {
+            return std::make_unique<PredicateRegex>(column, node["regex"].as<std::string>());
+        }
+        else if (node["range"])
+        {
+            double min = node["range"]["min"] ? node["range"]["min"].as<double>() : std::numeric_limits<double>::lowest();
+            double max = node["range"]["max"] ? node["range"]["max"].as<double>() : std::numeric_limits<double>::max();
+            return std::make_unique<PredicateRange>(column, min, max);
+        }
+        else if (node["not_empty"])
+        {
+            // There is no "empty" predicate, 'not_empty: false' would silently do the opposite
+            if (!node["not_empty"].as<bool>())
+            {
+                err.emplace_back("Predicate 'not_empty' on column '" + column + "' in filter '" + filter_name + "' can only be true");
+                return nullptr;
+            }
+            return std::make_unique<PredicateNotEmpty>(column);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        err.emplace_back("Malformed predicate on column '" + column + "' in filter '" + filter_name + "': " + e.what());
+        return nullptr;
+    }
+
+    err.emplace_back("Unknown predicate on column '" + column + "' in filter '" + filter_name + "'. Valid predicates are: equals, in, regex, range, not_empty, and, or");
+    return nullptr;
+}
+
+std::vector<std::unique_ptr<RowFilter>> ConfigParser::filters()
+{
+    std::vector<std::string> err;
+    std::vector<std::unique_ptr<RowFilter>> filters;
+    if (m_config["filters"])
+    {
+        size_t i = 0;
+        for (const auto &d : m_config["filters"])
+        {
+            std::string filter_name = d["name"] ? d["name"].as<std::string>() : "filter_" + std::to_string(i);
+            ++i;
+
+            std::unique_ptr<Predicate> predicate = compile_predicate(d, filter_name, err);
+            if (predicate)
+            {
+                Logging::INFO("Created filter '" + filter_name + "'", name);
+                filters.push_back(std::make_unique<RowFilter>(filter_name, std::move(predicate)));
+            }
+        }
+    }
+
+    if (!err.empty())
+    {
+        std::string errstr = std::accumulate(err.begin(), err.end(), std::string(), [](std::string running_str, const std::string &new_str)
+                                             { return running_str.empty() ? new_str : running_str + "\n" + new_str; });
+        Logging::ERROR(errstr, name);
+        kill(getpid(), SIGINT);
+    }
+
+    return filters;
+}
+
+/**
+ * Routes of the files of this configuration, restricted to the topics of the given schemas.
+ */
+std::vector<Route> ConfigParser::routes(const std::map<std::string, SchemaConfig> &schemas)
+{
+    std::vector<std::string> err;
+    std::vector<Route> routes;
+    if (m_config["routes"])
+    {
+        for (const auto &d : m_config["routes"])
+        {
+            if (!d["glob"] == !d["regex"])
+            {
+                err.emplace_back("A route needs either a glob or a regex");
+                continue;
+            }
+            bool regex = d["regex"].IsDefined();
+            std::string pattern = regex ? d["regex"].as<std::string>() : d["glob"].as<std::string>();
+
+            std::map<std::string, SchemaConfig> route_schemas;
+            for (const auto &topic : d["topics"])
+            {
+                auto it = schemas.find(topic.as<std::string>());
+                if (it == schemas.end())
+                {
+                    err.emplace_back("Unknown topic '" + topic.as<std::string>() + "' in route '" + pattern + "'");
+                    continue;
+                }
+                route_schemas.insert(*it);
+            }
+
+            std::optional<std::vector<std::unique_ptr<AbstractTransformer>>> route_transformers;
+            if (d["transforms"])
+            {
+                route_transformers = create_transformers(d["transforms"]);
+            }
+
+            try
+            {
+                routes.emplace_back(pattern, regex, std::move(route_schemas), std::move(route_transformers));
+                Logging::INFO("Created route '" + pattern + "'", name);
+            }
+            catch (const std::regex_error &e)
+            {
+                err.emplace_back("Invalid regex '" + pattern + "': " + e.what());
+            }
+        }
+    }
+
+    if (!err.empty())
+    {
+        std::string errstr = std::accumulate(err.begin(), err.end(), std::string(), [](std::string running_str, const std::string &new_str)
+                                             { return running_str.empty() ? new_str : running_str + "\n" + new_str; });
+        Logging::ERROR(errstr, name);
+        kill(getpid(), SIGINT);
+    }
+
+    return routes;
+}
+
+std::set<std::string> ConfigParser::required_columns()
+{
+    std::set<std::string> columns;
+
+    if (has_key("type_map"))
+    {
+        for (const auto &topic : m_config["type_map"])
+        {
+            const YAML::Node &value = topic.second;
+            if (value.Type() == YAML::NodeType::Map)
+            {
+                if (value["key_column"])
+                {
+                    columns.emplace(value["key_column"].as<std::string>());
+                }
+
+                for (const auto &column : value["columns"])
+                {
+                    columns.emplace(column.as<std::string>());
+                }
+            }
+        }
+    }
+
+    collect_transform_columns(m_config["transforms"], columns);
+    if (m_config["routes"])
+    {
+        for (const auto &d : m_config["routes"])
+        {
+            collect_transform_columns(d["transforms"], columns);
+        }
+    }
+
+    if (m_config["filters"])
+    {
+        for (const auto &d : m_config["filters"])
+        {
+            collect_predicate_columns(d, columns);
+        }
+    }
+
+    if (has_key("max_age"))
+    {
+        columns.emplace(max_age().first);
+    }
+
+    return columns;
+}
+
+/**
+ * The directories of the configuration, after dir_to_watch (-d) if given. A file must belong to
+ * exactly one of them, so a directory must not repeat another one or lie in a recursive one.
+ */
+std::vector<DirectoryConfig> ConfigParser::directories(const std::string &dir_to_watch)
+{
+    std::vector<std::string> err;
+    std::vector<DirectoryConfig> directories;
+    if (!dir_to_watch.empty())
+    {
+        directories.push_back(DirectoryConfig{dir_to_watch, false, ""});
+    }
+    if (m_config["directories"])
+    {
+        for (const auto &d : m_config["directories"])
+        {
+            if (!d["path"])
+            {
+                err.emplace_back("Missing path for directory");
+                continue;
+            }
+
+            DirectoryConfig directory{d["path"].as<std::string>(), d["recursive"] && d["recursive"].as<bool>(), d["profile"] ? d["profile"].as<std::string>() : ""};
+
+            struct stat info;
+            if (stat(directory.path.c_str(), &info) != 0 || !S_ISDIR(info.st_mode))
+            {
+                err.emplace_back("'" + directory.path + "' is not a directory");
+            }
+
+            if (!directory.profile.empty() && !m_config["profiles"][directory.profile])
+            {
+                err.emplace_back("Unknown profile '" + directory.profile + "' for directory '" + directory.path + "'");
+            }
+
+            directories.push_back(directory);
+        }
+    }
+
+    std::vector<std::filesystem::path> paths;
+    for (const DirectoryConfig &directory : directories)
+    {
+        std::error_code ec;
+        paths.push_back(std::filesystem::weakly_canonical(directory.path, ec));
+    }
+    for (size_t i = 0; i < directories.size(); ++i)
+    {
+        for (size_t j = 0; j < directories.size(); ++j)
+        {
+            if (i == j)
+            {
+                continue;
+            }
+
+            // Is j the same as or within the recursive directory i?
+            auto [end, it] = std::mismatch(paths[i].begin(), paths[i].end(), paths[j].begin(), paths[j].end());
+            if (end != paths[i].end())
+            {
+                continue;
+            }
+            if (it == paths[j].end() && i < j)
+            {
+                err.emplace_back("Directory '" + directories[j].path + "' is watched more than once");
+            }
+            else if (it != paths[j].end() && directories[i].recursive)
+            {
+                err.emplace_back("Directory '" + directories[j].path + "' is within the recursive directory '" + directories[i].path + "'");
+            }
+        }
+    }
+
+    if (!err.empty())
+    {
+        std::string errstr = std::accumulate(err.begin(), err.end(), std::string(), [](std::string running_str, const std::string &new_str)
+                                             { return running_str.empty() ? new_str : running_str + "\n" + new_str; });
+        Logging::ERROR(errstr, name);
+        kill(getpid(), SIGINT);
+    }
+
+    return directories;
+}
+
+/**
+ * The configuration with the sections of profiles.<profile_name> replacing the top-level ones.
+ * Only the sections that decide how rows are published can be overridden; everything else (Kafka,
+ * producer, sink, ...) is shared by all profiles. A profile with its own type_map does not
+ * inherit the top-level routes.
+ */
+std::unique_ptr<ConfigParser> ConfigParser::profile(const std::string &profile_name)
+{
+    static const std::set<std::string> profile_keys = {"type_map", "column_map", "column_type_transforms", "transforms", "filters", "max_age", "routes"};
+
+    YAML::Node config = YAML::Clone(m_config);
+    YAML::Node overrides = m_config["profiles"][profile_name];
+    if (overrides.Type() != YAML::NodeType::Map)
+    {
+        Logging::ERROR("Profile '" + profile_name + "' is not a map", name);
+        kill(getpid(), SIGINT);
+    }
+    else
+    {
+        for (auto it = overrides.begin(); it != overrides.end(); ++it)
+        {
+            std::string key = it->first.as<std::string>();
+            if (profile_keys.find(key) == profile_keys.end())
+            {
+                Logging::ERROR("Section '" + key + "' cannot be overridden by profile '" + profile_name + "'", name);
+                kill(getpid(), SIGINT);
+            }
+            config[key] = YAML::Clone(it->second);
+        }
+
+        // Top-level routes refer to the topics of the top-level type_map
+        if (overrides["type_map"] && !overrides["routes"])
+        {
+            config.remove("routes");
+        }
+    }
+
+    return std::unique_ptr<ConfigParser>(new ConfigParser(m_config_file, config));
+}
+
 ConfigParser::~ConfigParser() {};
\ No newline at end of file
@@ -2,17 +2,23 @@
 #define CONFIG_PARSER_H
 
 #include "transformers/AbstractTransformer.h"
+#include "filters/RowFilter.h"
+#include "routing/Route.h"
 #include "SchemaConfig.h"
+#include "DirectoryConfig.h"
+#include "impl/SchemaIdCache.h"
 #include <string>
 #include <yaml-cpp/yaml.h>
 #include <vector>
 #include <memory>
 #include <map>
+#include <set>
 
 class ConfigParser
 {
 private:
     ConfigParser(std::string c);
+    ConfigParser(std::string c, YAML::Node config);
     std::string m_config_file;
     YAML::Node m_config;
     std::string key_column(); // {'type_map' : {'vendor_mobility_in': {'key_column': 'abc', 'columns': ['id_type', 'timestamp', ...]}}}
@@ -22,6 +28,8 @@ private:
     avro::ValidSchema load_schema(const std::string file);
     int32_t fetch_schema_id_rest(const std::string &name, const std::string &registry);
     int32_t fetch_schema_id(const std::string &name);
+    std::vector<std::unique_ptr<AbstractTransformer>> create_transformers(const YAML::Node &transforms);
+    std::unique_ptr<Predicate> compile_predicate(const YAML::Node &node, const std::string &filter_name, std::vector<std::string> &err);
 
 public:
     /*
@@ -36,11 +44,25 @@ public:
     static ConfigParser &instance(std::string c);
     bool has_key(const std::string &k);
     std::vector<std::unique_ptr<AbstractTransformer>> transformers();
+    std::vector<std::unique_ptr<RowFilter>> filters();
+    std::vector<Route> routes(const std::map<std::string, SchemaConfig> &schemas);
     std::map<std::string, std::string> kafka();
+    std::map<std::string, std::string> producer();
+    std::map<std::string, std::string> sink();
+    std::map<std::string, std::string> metrics();
+    std::map<std::string, std::string> trace();
+    std::map<std::string, std::string> stream();
+    std::map<std::string, std::string> socket();
     std::map<std::string, std::string> column_map();
     std::map<std::string, std::string> column_type_transforms_map();
-    std::map<std::string, SchemaConfig> schemas();
+    std::map<std::string, SchemaConfig> schemas(SchemaIdCache *cache = nullptr, bool resolve_ids = true);
     std::pair<std::string, int> max_age();
+    std::string log_level();
+    size_t log_queue_bytes();
+    std::string report_file();
+    std::set<std::string> required_columns();
+    std::vector<DirectoryConfig> directories(const std::string &dir_to_watch = "");
+    std::unique_ptr<ConfigParser> profile(const std::string &profile_name);
     ~ConfigParser();
 };
 #endif
\ No newline at end of file
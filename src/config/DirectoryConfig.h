@@ -0,0 +1,21 @@
+/**
+ * @file DirectoryConfig
+ *
+ * @brief Plain-old-data structure to hold a directory to watch and the profile of its files.
+ *
+ */
+#ifndef DIRECTORY_CONFIG_H
+#define DIRECTORY_CONFIG_H
+
+#include <string>
+
+struct DirectoryConfig
+{
+    std::string path;
+    // Also watch all subdirectories, including the ones created later
+    bool recursive = false;
+    // Name of the profile the files are processed with, empty for the top-level configuration
+    std::string profile;
+};
+
+#endif
@@ -0,0 +1,37 @@
+/**
+ * @file Profile
+ *
+ * @brief Everything that decides how the rows of a file are published: the schema per topic, the
+ * transformers, the filters, the max age and the routes.
+ *
+ * The default profile (empty name) is the top-level configuration. Named profiles override parts of
+ * it, see ConfigParser::profile().
+ *
+ */
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "SchemaConfig.h"
+#include "transformers/AbstractTransformer.h"
+#include "filters/RowFilter.h"
+#include "routing/Route.h"
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+struct Profile
+{
+    std::map<std::string, SchemaConfig> schemas;
+    std::vector<std::unique_ptr<AbstractTransformer>> transformers;
+    std::vector<std::unique_ptr<RowFilter>> filters;
+    // Only these columns are materialised by the CSV parser
+    std::set<std::string> projection;
+    // Column and days, no max age if the column is empty
+    std::pair<std::string, int> max_age;
+    // The first route matching a file's name decides its topics and transformers
+    std::vector<Route> routes;
+};
+
+#endif
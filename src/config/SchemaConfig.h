@@ -12,6 +12,8 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include <atomic>
 #include <avro/Schema.hh>
 
 struct SchemaConfig
@@ -21,8 +23,10 @@ struct SchemaConfig
     const std::vector<std::string> columns;
     const std::map<std::string, std::string> column_map;
     const std::map<std::string, std::string> column_type_transforms;
-    avro::ValidSchema schema;
-    int32_t schema_id;
+    // Both are resolved once at startup (see ConfigParser::schemas()). A cached id may still be
+    // replaced by the registry's afterwards, see SchemaIdCache::refresh_async().
+    const avro::ValidSchema schema;
+    const std::shared_ptr<const std::atomic<int32_t>> schema_id;
 };
 
 #endif
\ No newline at end of file
@@ -1,8 +1,11 @@
 #include "CSVIterator.h"
+#include "trace/Trace.h"
 #include <sstream>
+#include <algorithm>
 
-CSVIterator::CSVIterator(std::istream &stream, bool has_header) : m_stream(stream.good() ? &stream : nullptr), m_has_header(has_header)
+CSVIterator::CSVIterator(std::istream &stream, bool has_header, const std::set<std::string> *projection, RowArena *arena) : m_stream(stream.good() ? &stream : nullptr), m_has_header(has_header), m_row(arena)
 {
+    m_row.set_projection(projection);
     ++(*this);
 }
 
@@ -29,6 +32,7 @@ void CSVIterator::set_columns(std::istream &stream)
 // Pre Increment
 CSVIterator &CSVIterator::operator++()
 {
+    TRACE_SPAN("CSVIterator::operator++");
     if (m_stream)
     {
         if (m_has_header)
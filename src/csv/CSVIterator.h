@@ -12,7 +12,7 @@ public:
     typedef CSVRow *pointer;
     typedef CSVRow &reference;
 
-    CSVIterator(std::istream &stream, bool has_header);
+    CSVIterator(std::istream &stream, bool has_header, const std::set<std::string> *projection = nullptr, RowArena *arena = nullptr);
     CSVIterator();
 
     // Pre Increment
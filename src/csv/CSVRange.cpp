@@ -1,12 +1,12 @@
 #include "CSVRange.h"
 
-CSVRange::CSVRange(std::istream &str, bool has_header) : m_stream(str), m_has_header(has_header)
+CSVRange::CSVRange(std::istream &str, bool has_header, const std::set<std::string> *projection, RowArena *arena) : m_stream(str), m_has_header(has_header), m_projection(projection), m_arena(arena)
 {
 }
 
 CSVIterator CSVRange::begin() const
 {
-    return CSVIterator{m_stream, m_has_header};
+    return CSVIterator{m_stream, m_has_header, m_projection, m_arena};
 }
 
 CSVIterator CSVRange::end() const
@@ -6,13 +6,15 @@
 class CSVRange
 {
 public:
-    CSVRange(std::istream &str, bool has_header);
+    CSVRange(std::istream &str, bool has_header, const std::set<std::string> *projection = nullptr, RowArena *arena = nullptr);
     CSVIterator begin() const;
     CSVIterator end() const;
 
 private:
     std::istream &m_stream;
     bool m_has_header;
+    const std::set<std::string> *m_projection;
+    RowArena *m_arena;
 };
 
 #endif
\ No newline at end of file
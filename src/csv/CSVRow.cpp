@@ -2,19 +2,36 @@
 #include <istream>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
 // std::string_view CSVRow::operator[](std::size_t index)
 // {
 //     return std::string_view(&m_line[m_data[index] + 1], m_data[index + 1] - (m_data[index] + 1));
 // }
 
+CSVRow::CSVRow(RowArena *arena) : m_arena(arena), m_fields(arena ? arena->resource() : std::pmr::get_default_resource()), m_map_data(arena ? arena->resource() : std::pmr::get_default_resource())
+{
+}
+
 std::string_view CSVRow::operator[](std::size_t index)
 {
-    return m_fields[index];
+    if (index < m_projected.size() && m_projected[index])
+    {
+        return m_fields[index];
+    }
+
+    // Column was not materialised. Return the raw slice between its delimiters.
+    return std::string_view(&m_line[m_data[index] + 1], m_data[index + 1] - (m_data[index] + 1));
 }
 
-std::string &CSVRow::operator[](const std::string column)
+CSVRow::Field &CSVRow::operator[](std::string_view column)
 {
-    return m_map_data[column];
+    auto it = m_map_data.find(column);
+    if (it == m_map_data.end())
+    {
+        // Column added by a transformer. Key and value are allocated like the rest of the row.
+        it = m_map_data.emplace(std::piecewise_construct, std::forward_as_tuple(column), std::forward_as_tuple()).first;
+    }
+    return it->second;
 }
 
 std::size_t CSVRow::size() const
@@ -54,26 +71,70 @@ void CSVRow::next(std::istream &stream)
     m_line.erase(std::remove(m_line.begin(), m_line.end(), '\n'), m_line.end());
     m_line.erase(std::remove(m_line.begin(), m_line.end(), '\r'), m_line.end());
 
-    m_fields.clear();
-    m_fields.push_back("");
+    /*
+    Only columns in the projection are copied into m_fields and m_map_data. For all other
+    columns we just remember the delimiter positions in m_data. The values of the previous
+    row are dropped at once by resetting the arena; the containers must not hold any arena
+    memory at that point, so m_fields gives up its storage too.
+    */
+    m_map_data.clear();
+    if (m_arena)
+    {
+        std::pmr::vector<Field>(m_fields.get_allocator()).swap(m_fields);
+        m_arena->reset();
+        m_fields.reserve(m_columns.size());
+    }
+    else
+    {
+        m_fields.clear();
+    }
+
+    m_data.clear();
+    m_data.emplace_back(-1);
+
     size_t i = 0; // index of the current field
-    for (char c : m_line)
+    bool projected = false;
+    auto begin_field = [this, &i, &projected]()
+    {
+        m_field.clear();
+        projected = i < m_projected.size() && m_projected[i];
+    };
+    auto end_field = [this, &i, &projected](size_t pos)
+    {
+        m_data.emplace_back(pos);
+        m_fields.emplace_back(projected ? std::string_view(m_field) : std::string_view());
+        if (projected)
+        {
+            auto [it, inserted] = m_map_data.emplace(std::piecewise_construct, std::forward_as_tuple(m_columns[i]), std::forward_as_tuple(m_field));
+            if (!inserted)
+            {
+                it->second = m_field;
+            }
+        }
+    };
+
+    begin_field();
+    for (size_t pos = 0; pos < m_line.size(); ++pos)
     {
+        char c = m_line[pos];
         switch (state)
         {
         case CSVState::UnquotedField:
             switch (c)
             {
             case ',': // end of field
-                m_map_data[m_columns[i]] = m_fields[i];
-                m_fields.push_back("");
+                end_field(pos);
                 i++;
+                begin_field();
                 break;
             case '"':
                 state = CSVState::QuotedField;
                 break;
             default:
-                m_fields[i].push_back(c);
+                if (projected)
+                {
+                    m_field.push_back(c);
+                }
                 break;
             }
             break;
@@ -84,7 +145,10 @@ void CSVRow::next(std::istream &stream)
                 state = CSVState::QuotedQuote;
                 break;
             default:
-                m_fields[i].push_back(c);
+                if (projected)
+                {
+                    m_field.push_back(c);
+                }
                 break;
             }
             break;
@@ -92,13 +156,16 @@ void CSVRow::next(std::istream &stream)
             switch (c)
             {
             case ',': // , after closing quote
-                m_map_data[m_columns[i]] = m_fields[i];
-                m_fields.push_back("");
+                end_field(pos);
                 i++;
+                begin_field();
                 state = CSVState::UnquotedField;
                 break;
             case '"': // "" -> "
-                m_fields[i].push_back('"');
+                if (projected)
+                {
+                    m_field.push_back('"');
+                }
                 state = CSVState::QuotedField;
                 break;
             default: // end of quote
@@ -109,12 +176,26 @@ void CSVRow::next(std::istream &stream)
         }
     }
 
-    m_map_data[m_columns[i]] = m_fields[i];
+    end_field(m_line.size());
 }
 
 void CSVRow::set_columns(std::vector<std::string> &&columns)
 {
     m_columns = columns;
+    set_projection(m_projection);
+}
+
+void CSVRow::set_projection(const std::set<std::string> *projection)
+{
+    m_projection = projection;
+    m_projected.assign(m_columns.size(), true);
+    if (m_projection && !m_projection->empty())
+    {
+        for (size_t i = 0; i < m_columns.size(); ++i)
+        {
+            m_projected[i] = m_projection->find(m_columns[i]) != m_projection->end();
+        }
+    }
 }
 
 std::istream &operator>>(std::istream &stream, CSVRow &data)
@@ -127,9 +208,16 @@ CSVRow::operator std::string()
 {
     std::stringstream ss;
     std::string sep = "";
-    for (const std::string &col : m_columns)
+    for (size_t i = 0; i < m_columns.size() && i < size(); ++i)
     {
-        ss << sep << (*this)[col];
+        if (m_projected[i])
+        {
+            ss << sep << (*this)[std::string_view(m_columns[i])];
+        }
+        else
+        {
+            ss << sep << (*this)[i];
+        }
         sep.assign(",");
     }
     return ss.str();
@@ -138,4 +226,5 @@ CSVRow::operator std::string()
 std::ostream &operator<<(std::ostream &str, CSVRow &row)
 {
     str << (std::string)row;
+    return str;
 }
\ No newline at end of file
@@ -1,11 +1,14 @@
 #ifndef CSVROW_H
 #define CSVROW_H
+#include "RowArena.h"
 #include <string_view>
 #include <cstddef>
 #include <istream>
 #include <string>
 #include <vector>
 #include <map>
+#include <memory_resource>
+#include <set>
 
 enum class CSVState
 {
@@ -17,19 +20,34 @@ enum class CSVState
 class CSVRow
 {
 public:
+    /*
+    Values of the row. With a RowArena they live in the arena and are only valid until the
+    next row is read.
+    */
+    typedef std::pmr::string Field;
+
+    CSVRow(RowArena *arena = nullptr);
+
     std::string_view operator[](std::size_t index);
-    std::string &operator[](const std::string column);
+    Field &operator[](std::string_view column);
     std::size_t size() const;
     void next(std::istream &str);
     void set_columns(std::vector<std::string> &&columns);
+    void set_projection(const std::set<std::string> *projection);
     operator std::string();
 
 private:
+    RowArena *m_arena;
     std::string m_line;
-    std::vector<std::string> m_fields;
+    std::string m_field; // field being parsed, copied into the arena once complete
+    std::pmr::vector<Field> m_fields;
     std::vector<int> m_data;
     std::vector<std::string> m_columns;
-    std::map<std::string, std::string> m_map_data;
+    std::pmr::map<Field, Field, std::less<>> m_map_data;
+
+    // Columns that are materialised into m_fields/m_map_data. nullptr means all columns.
+    const std::set<std::string> *m_projection = nullptr;
+    std::vector<bool> m_projected;
 
     // The non-member function operator>> will have access to CSVRow's private members
     friend std::istream &operator>>(std::istream &str, CSVRow &data);
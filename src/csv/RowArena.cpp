@@ -0,0 +1,48 @@
+#include "RowArena.h"
+
+void *RowArena::Overflow::do_allocate(size_t bytes, size_t alignment)
+{
+    m_bytes += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void RowArena::Overflow::do_deallocate(void *p, size_t bytes, size_t alignment)
+{
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+bool RowArena::Overflow::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+RowArena::RowArena(size_t initial_size) : m_buffer(initial_size)
+{
+    m_resource.emplace(m_buffer.data(), m_buffer.size(), &m_overflow);
+}
+
+std::pmr::memory_resource *RowArena::resource()
+{
+    return &*m_resource;
+}
+
+void RowArena::reset()
+{
+    if (m_overflow.m_bytes == 0)
+    {
+        m_resource->release();
+        return;
+    }
+
+    // The last row didn't fit. Grow the buffer so that the next ones do.
+    size_t size = 2 * (m_buffer.size() + m_overflow.m_bytes);
+    m_resource.reset();
+    m_overflow.m_bytes = 0;
+    m_buffer.assign(size, std::byte{0});
+    m_resource.emplace(m_buffer.data(), m_buffer.size(), &m_overflow);
+}
+
+size_t RowArena::capacity() const
+{
+    return m_buffer.size();
+}
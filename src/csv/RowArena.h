@@ -0,0 +1,55 @@
+/**
+ * Bump-pointer arena for the fields of a single CSV row and the values the transformers
+ * derive from them.
+ *
+ * Allocations are served from one buffer and never freed individually; reset() discards
+ * all of them at once before the next row. A row that doesn't fit spills over to the heap,
+ * and the buffer is grown on the next reset() so that the steady state doesn't allocate.
+ * Used by a single processor thread.
+ **/
+#ifndef ROW_ARENA_H
+#define ROW_ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+class RowArena
+{
+private:
+    /**
+     * Heap fallback of the arena, remembering how much the current row needed on top of
+     * the buffer.
+     **/
+    class Overflow : public std::pmr::memory_resource
+    {
+    public:
+        size_t m_bytes = 0;
+
+    private:
+        void *do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+    };
+
+    std::vector<std::byte> m_buffer;
+    Overflow m_overflow;
+    std::optional<std::pmr::monotonic_buffer_resource> m_resource;
+
+public:
+    RowArena(size_t initial_size = 64 * 1024);
+    RowArena(const RowArena &) = delete;
+    void operator=(const RowArena &) = delete;
+
+    std::pmr::memory_resource *resource();
+
+    /**
+     * Discard all allocations. Nothing allocated from the arena may be used afterwards.
+     **/
+    void reset();
+
+    size_t capacity() const;
+};
+
+#endif
@@ -0,0 +1,177 @@
+#include "MaxAgeFilter.h"
+#include <charconv>
+#include <stdexcept>
+
+static constexpr long SECONDS_PER_DAY = 60 * 60 * 24;
+
+/**
+ * Read exactly n digits starting at pos.
+ **/
+static bool read_digits(std::string_view s, size_t pos, size_t n, int &out)
+{
+    if (pos + n > s.size())
+    {
+        return false;
+    }
+
+    out = 0;
+    for (size_t i = pos; i < pos + n; ++i)
+    {
+        if (s[i] < '0' || s[i] > '9')
+        {
+            return false;
+        }
+        out = out * 10 + (s[i] - '0');
+    }
+    return true;
+}
+
+/**
+ * Days since 1970-01-01 for a date in the proleptic Gregorian calendar.
+ * See http://howardhinnant.github.io/date_algorithms.html#days_from_civil
+ **/
+static long days_from_civil(long y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    const long era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<long>(doe) - 719468;
+}
+
+MaxAgeFilter::MaxAgeFilter(std::string column, int days) : m_column(column), m_days(days)
+{
+    refresh();
+}
+
+void MaxAgeFilter::refresh()
+{
+    m_now = time(NULL);
+
+    /*
+    An event is dropped if the number of whole days since the event is larger than m_days,
+    i.e. (now - ts) / SECONDS_PER_DAY > m_days which is the same as ts <= now - (m_days + 1) * SECONDS_PER_DAY
+    */
+    m_cutoff = static_cast<long>(m_now) - (static_cast<long>(m_days) + 1) * SECONDS_PER_DAY;
+}
+
+bool MaxAgeFilter::accept(CSVRow &row) const
+{
+    long event_timestamp;
+    std::string_view value = row[m_column];
+    if (!parse_timestamp(value, event_timestamp))
+    {
+        throw std::invalid_argument("Invalid timestamp '" + std::string(value) + "' in column '" + m_column + "'");
+    }
+
+    return event_timestamp > m_cutoff;
+}
+
+const std::string &MaxAgeFilter::column() const
+{
+    return m_column;
+}
+
+int MaxAgeFilter::days() const
+{
+    return m_days;
+}
+
+bool MaxAgeFilter::parse_timestamp(std::string_view s, long &out)
+{
+    if (s.empty())
+    {
+        return false;
+    }
+
+    // Fast path: seconds since the Epoch
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), out);
+    if (ec == std::errc() && ptr == s.data() + s.size())
+    {
+        return true;
+    }
+
+    // ISO-8601: YYYY-MM-DD[(T| )hh:mm[:ss[.fff]]][Z|(+|-)hh[:]mm]
+    int year, month, day, hour = 0, minute = 0, second = 0;
+    if (!read_digits(s, 0, 4, year) || s.size() < 10 || s[4] != '-' || !read_digits(s, 5, 2, month) || s[7] != '-' || !read_digits(s, 8, 2, day))
+    {
+        return false;
+    }
+
+    if (month < 1 || month > 12 || day < 1 || day > 31)
+    {
+        return false;
+    }
+
+    size_t pos = 10;
+    if (pos < s.size() && (s[pos] == 'T' || s[pos] == ' '))
+    {
+        if (!read_digits(s, pos + 1, 2, hour) || pos + 3 >= s.size() || s[pos + 3] != ':' || !read_digits(s, pos + 4, 2, minute))
+        {
+            return false;
+        }
+        pos += 6;
+
+        if (pos < s.size() && s[pos] == ':')
+        {
+            if (!read_digits(s, pos + 1, 2, second))
+            {
+                return false;
+            }
+            pos += 3;
+
+            // Fractional seconds are ignored
+            if (pos < s.size() && (s[pos] == '.' || s[pos] == ','))
+            {
+                ++pos;
+                while (pos < s.size() && s[pos] >= '0' && s[pos] <= '9')
+                {
+                    ++pos;
+                }
+            }
+        }
+    }
+
+    long offset = 0;
+    if (pos < s.size())
+    {
+        if (s[pos] == 'Z')
+        {
+            ++pos;
+        }
+        else if (s[pos] == '+' || s[pos] == '-')
+        {
+            int sign = s[pos] == '-' ? -1 : 1;
+            int offset_hours, offset_minutes = 0;
+            if (!read_digits(s, pos + 1, 2, offset_hours))
+            {
+                return false;
+            }
+            pos += 3;
+
+            if (pos < s.size() && s[pos] == ':')
+            {
+                ++pos;
+            }
+
+            if (pos < s.size())
+            {
+                if (!read_digits(s, pos, 2, offset_minutes))
+                {
+                    return false;
+                }
+                pos += 2;
+            }
+            offset = sign * (offset_hours * 3600L + offset_minutes * 60L);
+        }
+    }
+
+    if (pos != s.size())
+    {
+        return false;
+    }
+
+    out = days_from_civil(year, month, day) * SECONDS_PER_DAY + hour * 3600L + minute * 60L + second - offset;
+    return true;
+}
@@ -0,0 +1,50 @@
+/**
+ * Drop rows whose event timestamp is older than a configured number of days.
+ *
+ * Evaluated right after a row was parsed and before any transformer or serializer
+ * touches it. The current time is cached and only refreshed by calling refresh(), so
+ * the per-row cost is a single integer comparison against a precomputed cutoff.
+ *
+ * The timestamp column may hold either seconds since the Epoch (e.g. 1668496399) or
+ * an ISO-8601 date/time (e.g. 2022-11-15, 2022-11-15T07:13:19Z, 2022-11-15 07:13:19.029+01:00).
+ **/
+#ifndef MAX_AGE_FILTER_H
+#define MAX_AGE_FILTER_H
+
+#include "csv/CSVRow.h"
+#include <string>
+#include <string_view>
+#include <ctime>
+
+class MaxAgeFilter
+{
+public:
+    MaxAgeFilter(std::string column, int days);
+
+    /**
+     * Re-read the clock and recompute the cutoff. Call once per batch of rows.
+     **/
+    void refresh();
+
+    /**
+     * Returns true if the row should be kept. Throws std::invalid_argument if the
+     * timestamp column cannot be parsed.
+     **/
+    bool accept(CSVRow &row) const;
+
+    const std::string &column() const;
+    int days() const;
+
+    /**
+     * Parse seconds since the Epoch or an ISO-8601 date/time into seconds since the Epoch (UTC).
+     **/
+    static bool parse_timestamp(std::string_view value, long &out);
+
+private:
+    std::string m_column;
+    int m_days;
+    time_t m_now = 0;
+    long m_cutoff = 0;
+};
+
+#endif
@@ -0,0 +1,92 @@
+#include "Predicate.h"
+#include <charconv>
+
+Predicate::~Predicate(){};
+
+ColumnPredicate::ColumnPredicate(std::string column) : m_column(column)
+{
+}
+
+PredicateEquals::PredicateEquals(std::string column, std::string value) : ColumnPredicate(column), m_value(value)
+{
+}
+
+bool PredicateEquals::evaluate(CSVRow &row) const
+{
+    return std::string_view(row[m_column]) == m_value;
+}
+
+PredicateIn::PredicateIn(std::string column, std::unordered_set<std::string> values) : ColumnPredicate(column), m_values(values.begin(), values.end())
+{
+}
+
+bool PredicateIn::evaluate(CSVRow &row) const
+{
+    return m_values.find(std::string_view(row[m_column])) != m_values.end();
+}
+
+PredicateRegex::PredicateRegex(std::string column, const std::string &pattern) : ColumnPredicate(column), m_regex(pattern, std::regex::ECMAScript | std::regex::optimize)
+{
+}
+
+bool PredicateRegex::evaluate(CSVRow &row) const
+{
+    return std::regex_search(row[m_column], m_regex);
+}
+
+PredicateRange::PredicateRange(std::string column, double min, double max) : ColumnPredicate(column), m_min(min), m_max(max)
+{
+}
+
+bool PredicateRange::evaluate(CSVRow &row) const
+{
+    const CSVRow::Field &value = row[m_column];
+    double number;
+    auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), number);
+    if (ec != std::errc() || ptr != value.data() + value.size())
+    {
+        return false;
+    }
+    return number >= m_min && number <= m_max;
+}
+
+PredicateNotEmpty::PredicateNotEmpty(std::string column) : ColumnPredicate(column)
+{
+}
+
+bool PredicateNotEmpty::evaluate(CSVRow &row) const
+{
+    return !row[m_column].empty();
+}
+
+PredicateAnd::PredicateAnd(std::vector<std::unique_ptr<Predicate>> operands) : m_operands(std::move(operands))
+{
+}
+
+bool PredicateAnd::evaluate(CSVRow &row) const
+{
+    for (const auto &operand : m_operands)
+    {
+        if (!operand->evaluate(row))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+PredicateOr::PredicateOr(std::vector<std::unique_ptr<Predicate>> operands) : m_operands(std::move(operands))
+{
+}
+
+bool PredicateOr::evaluate(CSVRow &row) const
+{
+    for (const auto &operand : m_operands)
+    {
+        if (operand->evaluate(row))
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,130 @@
+/**
+ * Predicates evaluated on a parsed CSV row. Compiled once from the 'filters' section of the
+ * configuration and shared (read-only) by all processor threads.
+ **/
+#ifndef PREDICATE_H
+#define PREDICATE_H
+
+#include "csv/CSVRow.h"
+#include <memory>
+#include <regex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+class Predicate
+{
+public:
+    virtual ~Predicate();
+    virtual bool evaluate(CSVRow &row) const = 0;
+};
+
+/**
+ * Base for predicates testing the value of a single column.
+ **/
+class ColumnPredicate : public Predicate
+{
+protected:
+    const std::string m_column;
+
+public:
+    ColumnPredicate(std::string column);
+};
+
+/**
+ * row[column] == value
+ **/
+class PredicateEquals : public ColumnPredicate
+{
+private:
+    const std::string m_value;
+
+public:
+    PredicateEquals(std::string column, std::string value);
+    bool evaluate(CSVRow &row) const override;
+};
+
+/**
+ * row[column] is one of values
+ **/
+class PredicateIn : public ColumnPredicate
+{
+private:
+    // Transparent, so that row values are looked up without a copy
+    struct Hash
+    {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+    };
+
+    const std::unordered_set<std::string, Hash, std::equal_to<>> m_values;
+
+public:
+    PredicateIn(std::string column, std::unordered_set<std::string> values);
+    bool evaluate(CSVRow &row) const override;
+};
+
+/**
+ * row[column] matches the (ECMAScript) regular expression somewhere
+ **/
+class PredicateRegex : public ColumnPredicate
+{
+private:
+    const std::regex m_regex;
+
+public:
+    PredicateRegex(std::string column, const std::string &pattern);
+    bool evaluate(CSVRow &row) const override;
+};
+
+/**
+ * min <= row[column] <= max. Values that are not numbers never match.
+ **/
+class PredicateRange : public ColumnPredicate
+{
+private:
+    const double m_min;
+    const double m_max;
+
+public:
+    PredicateRange(std::string column, double min, double max);
+    bool evaluate(CSVRow &row) const override;
+};
+
+/**
+ * !row[column].empty()
+ **/
+class PredicateNotEmpty : public ColumnPredicate
+{
+public:
+    PredicateNotEmpty(std::string column);
+    bool evaluate(CSVRow &row) const override;
+};
+
+/**
+ * All of the operands are true. Short-circuits on the first false operand.
+ **/
+class PredicateAnd : public Predicate
+{
+private:
+    std::vector<std::unique_ptr<Predicate>> m_operands;
+
+public:
+    PredicateAnd(std::vector<std::unique_ptr<Predicate>> operands);
+    bool evaluate(CSVRow &row) const override;
+};
+
+/**
+ * Any of the operands is true. Short-circuits on the first true operand.
+ **/
+class PredicateOr : public Predicate
+{
+private:
+    std::vector<std::unique_ptr<Predicate>> m_operands;
+
+public:
+    PredicateOr(std::vector<std::unique_ptr<Predicate>> operands);
+    bool evaluate(CSVRow &row) const override;
+};
+
+#endif
@@ -0,0 +1,15 @@
+#include "RowFilter.h"
+
+RowFilter::RowFilter(std::string name, std::unique_ptr<Predicate> predicate) : m_name(name), m_predicate(std::move(predicate))
+{
+}
+
+bool RowFilter::accept(CSVRow &row)
+{
+    return m_predicate->evaluate(row);
+}
+
+const std::string &RowFilter::name() const
+{
+    return m_name;
+}
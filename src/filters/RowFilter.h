@@ -0,0 +1,30 @@
+/**
+ * A named entry of the 'filters' section. Rows for which the predicate evaluates to
+ * false are dropped. The callers count the dropped rows.
+ **/
+#ifndef ROW_FILTER_H
+#define ROW_FILTER_H
+
+#include "Predicate.h"
+#include <memory>
+#include <string>
+
+class RowFilter
+{
+private:
+    const std::string m_name;
+    std::unique_ptr<Predicate> m_predicate;
+
+public:
+    RowFilter(std::string name, std::unique_ptr<Predicate> predicate);
+    RowFilter(const RowFilter &) = delete;
+    void operator=(const RowFilter &) = delete;
+
+    /**
+     * Returns true if the row should be kept.
+     **/
+    bool accept(CSVRow &row);
+    const std::string &name() const;
+};
+
+#endif
@@ -2,8 +2,12 @@
 #include "logging/Logging.h"
 #include "CsvProcessorBuilder.h"
 #include "csv/CSVRange.h"
-#include "impl/SchemaRegistry.h"
+#include "io/InputFileStream.h"
+#include "io/PipeStreamBuf.h"
+#include "io/MemoryStreamBuf.h"
 #include "Util.h"
+#include "metrics/Metrics.h"
+#include "trace/Trace.h"
 #include <thread>
 #include <iostream>
 #include <fstream>
@@ -15,16 +19,47 @@
 #include <avro/Decoder.hh>
 #include <avro/Compiler.hh>
 #include <signal.h>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
 #include <exception>
 #include <stdexcept>
 #include <typeinfo>
-#include <time.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <numeric>
+
+/* Number of rows after which the cached "now" of the max age filter is refreshed */
+static constexpr size_t MAX_AGE_REFRESH_ROWS = 1024;
+
+/* Number of rows per checkpoint segment */
+static constexpr size_t CHECKPOINT_SEGMENT_ROWS = 4096;
+
+/* Time after which an idle stream checks for a pending flush and a shutdown */
+static constexpr int STREAM_IDLE_MS = 100;
+
+/* Number of streamed rows after which the flush interval is checked */
+static constexpr size_t STREAM_CLOCK_ROWS = 1024;
+
+static Metrics::Counter &rows_read_total = Metrics::Registry::instance().counter("flycatcher_rows_read_total", "CSV rows read");
+static Metrics::Counter &row_errors_total = Metrics::Registry::instance().counter("flycatcher_row_errors_total", "CSV rows that failed to transform or convert");
+static Metrics::Counter &messages_total = Metrics::Registry::instance().counter("flycatcher_messages_total", "Messages handed to the sink");
+static Metrics::Counter &message_bytes_total = Metrics::Registry::instance().counter("flycatcher_message_bytes_total", "Payload bytes handed to the sink");
+static Metrics::Counter &files_done_total = Metrics::Registry::instance().counter("flycatcher_files_processed_total", "Processed files", Metrics::label("result", "done"));
+static Metrics::Counter &files_incomplete_total = Metrics::Registry::instance().counter("flycatcher_files_processed_total", "Processed files", Metrics::label("result", "incomplete"));
+static Metrics::Histogram &file_duration = Metrics::Registry::instance().histogram("flycatcher_file_duration_seconds", "Time to process a file", Metrics::exponential_buckets(0.1, 2, 14));
+
+static void count_filtered(const std::string &filter, size_t count)
+{
+  Metrics::Registry::instance().counter("flycatcher_rows_filtered_total", "CSV rows dropped by filters", Metrics::label("filter", filter)).inc(count);
+}
 
 CsvProcessor::CsvProcessor(std::string name, std::shared_ptr<SignalChannel> sig_channel) : AbstractProcessor(name, sig_channel)
 {
 }
 
-ssize_t CsvProcessor::serialize(avro::ValidSchema schema, const int32_t schema_id, const avro::GenericDatum datum, std::vector<char> &out, std::string &errstr)
+ssize_t CsvProcessor::serialize(const avro::ValidSchema &schema, const int32_t schema_id, const avro::GenericDatum &datum, std::vector<char> &out, std::string &errstr)
 {
   auto output_stream = avro::memoryOutputStream();
   auto encoder = avro::validatingEncoder(schema, avro::binaryEncoder());
@@ -66,171 +101,285 @@ ssize_t CsvProcessor::serialize(avro::ValidSchema schema, const int32_t schema_i
   return out.size();
 }
 
-void CsvProcessor::publish(CSVRow &row, size_t &old_count)
+void CsvProcessor::publish(CSVRow &row)
 {
   // Create Avro record
-  std::vector<char> out_data;
-  for (auto &[topic, schema_config] : *m_schemas)
+  for (const auto &[topic, schema_config] : *m_schemas)
   {
     const avro::ValidSchema &schema = schema_config.schema;
     avro::GenericDatum datum(schema);
     avro::GenericRecord &record = datum.value<avro::GenericRecord>();
+    static const std::string string_type = "string";
     for (const auto &field : schema_config.columns)
     {
-      std::string field_name = field;
-
       auto name_it = schema_config.column_map.find(field);
-      if (name_it != schema_config.column_map.end())
-      {
-        field_name.assign(name_it->second);
-      }
-
-      /* Check max age now that we got the new field name */
-      if (m_max_age_config)
-      {
-        if (!field_name.compare(m_max_age_config->first))
-        {
-          long event_timestamp = stol(row[field]);
-          time_t now = time(NULL);
-          int days_since_event = (now - event_timestamp) / (60 * 60 * 24);
+      const std::string &field_name = name_it != schema_config.column_map.end() ? name_it->second : field;
 
-          if (days_since_event > m_max_age_config->second)
-          {
-            ++old_count;
-            return;
-          }
-        }
-      }
-
-      std::string type = "string";
       auto type_it = schema_config.column_type_transforms.find(field);
-      if (type_it != schema_config.column_type_transforms.end())
-      {
-        type.assign(type_it->second);
-      }
+      const std::string &type = type_it != schema_config.column_type_transforms.end() ? type_it->second : string_type;
 
       record.setFieldAt(record.fieldIndex(field_name), Util::create_datum_for_type(row[field], type));
     }
 
-    // Register schema
-    if (schema_config.schema_id == -1)
+    std::vector<char> out_data;
+    std::string errstr;
+    ssize_t serialized;
     {
-      schema_config.schema_id = SchemaRegistry::instance().register_value_schema(topic, schema_config.schema.toJson());
+      TRACE_SPAN("serialize");
+      serialized = serialize(schema, schema_config.schema_id->load(std::memory_order_relaxed), datum, out_data, errstr);
     }
-
-    std::string errstr;
-    if (serialize(schema, schema_config.schema_id, datum, out_data, errstr) == -1)
+    if (serialized == -1)
     {
       Logging::ERROR("Avro serialization failed: " + errstr, m_name);
       kill(getpid(), SIGINT);
     }
     else
     {
-    retry:
-      RdKafka::ErrorCode err = m_kafka_producer->produce(topic,
-                                                         RdKafka::Topic::PARTITION_UA,
-                                                         RdKafka::Producer::RK_MSG_COPY,
-                                                         /* Value */
-                                                         out_data.data(),
-                                                         out_data.size(),
-                                                         /* Key */
-                                                         row[schema_config.key_column].c_str(),
-                                                         /* Key len */
-                                                         row[schema_config.key_column].length(),
-                                                         /* Timestamp (defaults to current time) */
-                                                         0,
-                                                         /* Message headers, if any */
-                                                         NULL,
-                                                         /* Per-message opaque value passed to
-                                                          * delivery report */
-                                                         NULL);
-      if (err != RdKafka::ERR_NO_ERROR)
+      CheckpointSegment *segment = nullptr;
+      if (m_checkpoint)
       {
-        Logging::ERROR("Failed to produce to topic '" + topic + "': " + RdKafka::err2str(err), m_name);
+        segment = m_checkpoint->current();
+        segment->add(1);
+      }
+      m_timer.lap(m_report.serialize);
 
-        if (err == RdKafka::ERR__QUEUE_FULL)
-        {
-          /* If the internal queue is full, wait for
-           * messages to be delivered and then retry.
-           * The internal queue represents both
-           * messages to be sent and messages that have
-           * been sent or failed, awaiting their
-           * delivery report callback to be called.
-           *
-           * The internal queue is limited by the
-           * configuration property
-           * queue.buffering.max.messages and queue.buffering.max.kbytes */
-          m_kafka_producer->poll(1000 /*block for max 1000ms*/);
-          goto retry;
-        }
+      messages_total.inc();
+      message_bytes_total.inc(out_data.size());
+      ++m_report.messages;
+      m_report.bytes_out += out_data.size();
+      try
+      {
+        TRACE_SPAN("produce");
+        m_sink->produce(topic, row[schema_config.key_column], std::move(out_data), segment);
       }
-      else
+      catch (...)
       {
-        Logging::DEBUG("Enqueued message (" + std::to_string(out_data.size()) + " bytes) for topic '" + topic + "'", m_name);
+        // Release the reference taken above, otherwise the segment never completes
+        if (segment)
+        {
+          segment->ack(false);
+        }
+        throw;
       }
+      m_timer.lap(m_report.produce);
+    }
+  }
+}
+
+bool CsvProcessor::process_row(CSVRow &row, size_t &row_count, size_t &old_count, std::vector<size_t> &filtered_counts)
+{
+  // Drop old rows before spending any time on transformations and serialization
+  if (m_max_age_filter)
+  {
+    if ((row_count++ % MAX_AGE_REFRESH_ROWS) == 0)
+    {
+      m_max_age_filter->refresh();
+    }
+
+    if (!m_max_age_filter->accept(row))
+    {
+      ++old_count;
+      m_timer.lap(m_report.filter);
+      return false;
+    }
+  }
+
+  if (m_filters && !apply_filters(row, filtered_counts))
+  {
+    m_timer.lap(m_report.filter);
+    return false;
+  }
+  m_timer.lap(m_report.filter);
+
+  // Proceed with transformations
+  {
+    TRACE_SPAN("transform");
+    for (const auto &transformer_ptr : *m_transformers)
+    {
+      transformer_ptr->Operation(row);
+    }
+  }
+  m_timer.lap(m_report.transform);
+  publish(row);
+  return true;
+}
+
+bool CsvProcessor::apply_filters(CSVRow &row, std::vector<size_t> &filtered_counts)
+{
+  for (size_t i = 0; i < m_filters->size(); ++i)
+  {
+    if (!(*m_filters)[i]->accept(row))
+    {
+      ++filtered_counts[i];
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Select the schemas, transformers, filters and max age the rows of the next file are published with.
+ */
+bool CsvProcessor::use_profile(const std::string &profile_name)
+{
+  auto it = m_profiles->find(profile_name);
+  if (it == m_profiles->end())
+  {
+    Logging::ERROR("Unknown profile '" + profile_name + "'", m_name);
+    return false;
+  }
 
-      /* Wait for final messages to be delivered or fail.
-       * flush() is an abstraction over poll() which
-       * waits for all messages to be delivered. */
-      Logging::DEBUG("Flushing final messages...", m_name);
-      m_kafka_producer->flush(10 * 1000 /* wait for max 10 seconds */);
+  Profile &profile = it->second;
+  m_profile = &profile;
+  m_schemas = &profile.schemas;
+  m_transformers = &profile.transformers;
+  m_filters = profile.filters.empty() ? nullptr : &profile.filters;
+  m_projection = &profile.projection;
+
+  // The cutoff is refreshed with the first row
+  if (profile.max_age.first.empty())
+  {
+    m_max_age_filter.reset();
+  }
+  else
+  {
+    m_max_age_filter.emplace(profile.max_age.first, profile.max_age.second);
+  }
+  return true;
+}
 
-      if (m_kafka_producer->outq_len() > 0)
+/**
+ * Restrict the topics and replace the transformers for the file, if a route of the profile matches its name.
+ */
+void CsvProcessor::use_route(const std::string &file_path)
+{
+  std::string file_name = std::filesystem::path(file_path).filename();
+  for (Route &route : m_profile->routes)
+  {
+    if (route.matches(file_name))
+    {
+      if (!route.schemas().empty())
+      {
+        m_schemas = &route.schemas();
+      }
+      if (route.transformers())
       {
-        Logging::ERROR(std::to_string(m_kafka_producer->outq_len()) + " message(s) were not delivered", m_name);
+        m_transformers = route.transformers();
       }
+      LOG_DEBUG("Route '" + route.pattern() + "' publishes '" + file_name + "' to " + std::to_string(m_schemas->size()) + " topic(s)", m_name);
+      return;
     }
   }
 }
 
 void CsvProcessor::handle(PollResult d)
 {
-  /*
-  Atomic since we are modifying it from multiple processors and we want it to be be threadsafe.
-
-  Although atomic and threadsafe when multiple CsvProcessors are modifying it is better to lock in case:
-  1. A LogProcessor was waken up (maybe by a different CsvProcessor) and is ready to check the condition to see if it is allowed to log.
-  It expects the condition to be true. At this point the LogProcessor is not in a waiting state.
-  2. Just before it manages to reacquire the mutex and check, another CsvProcessor is scheduled and wants to parse a CSV file.
-  Because we want the CsvProcessors to have higher priority than logging, we quickly lock the mutex to prevent the
-  LogProcessor from doing its work. Even if it is just checking the condition.
-
-  But then again... if we are locking anyways we don't really need atomic.
-  */
+  if (!use_profile(d.profile()))
+  {
+    return;
+  }
+  if (m_streaming)
   {
-    std::unique_lock lock(*m_log_cv_mutex);
-    m_active_processors->fetch_add(1);
+    handle_stream(d.get());
+    return;
+  }
+  if (d.data())
+  {
+    handle_batch(d);
+    return;
   }
 
+  TRACE_SPAN("CsvProcessor::handle");
+  auto started = std::chrono::steady_clock::now();
   size_t old_count = 0;
+  std::vector<size_t> filtered_counts(m_filters ? m_filters->size() : 0, 0);
 
   std::stringstream ss;
   ss << "Processing '" << d.get() << "'";
+  if (!d.profile().empty())
+  {
+    ss << " with profile '" << d.profile() << "'";
+  }
   Logging::INFO(ss.str(), m_name);
 
-  std::string tmp_file_path = d.get() + "_inprogress";
-  if (rename(d.get().c_str(), tmp_file_path.c_str()) == 0)
+  // Files still in progress from a previous run are picked up again on startup
+  std::string file_path = d.get();
+  std::string tmp_file_path = file_path + "_inprogress";
+  bool resuming = Util::str_ends_with(file_path.c_str(), "_inprogress");
+  if (resuming)
   {
-    std::ifstream file(tmp_file_path);
+    tmp_file_path = file_path;
+    file_path.resize(file_path.size() - std::string("_inprogress").size());
+  }
+  use_route(file_path);
+
+  if (resuming || rename(file_path.c_str(), tmp_file_path.c_str()) == 0)
+  {
+    m_report = FileReport();
+    m_report.file = file_path;
+    m_report.queue_wait = started - d.created();
+    std::error_code ec;
+    m_report.bytes_in = std::filesystem::file_size(tmp_file_path, ec);
+    if (ec)
+    {
+      m_report.bytes_in = 0;
+    }
+    m_timer.start(m_report_writer != nullptr);
+
+    // Transparently decompresses gzip, zstd and lz4 files on a separate thread
+    InputFileStream file(tmp_file_path);
+
+    if (!m_sink)
+    {
+      m_sink = m_sink_factory->create(m_name);
+    }
+    if (!m_arena)
+    {
+      m_arena = new RowArena();
+    }
+
+    std::optional<FileCheckpoint> checkpoint;
+    size_t resume_row = 0;
+    if (m_checkpoints)
+    {
+      checkpoint.emplace(file_path + "_checkpoint", tmp_file_path);
+      m_checkpoint = &*checkpoint;
+      resume_row = checkpoint->resume_row();
+    }
+    size_t rows_read = 0;
 
     short exc_count = 0;
+    size_t row_count = 0;
+    // The rest of the file was not processed, e.g. a truncated or corrupt compressed file
+    bool read_failed = false;
     try
     {
-      for (auto &row : CSVRange(file, true))
+      for (auto &row : CSVRange(file, true, m_projection, m_arena))
       {
+        // Rows acknowledged in a previous run
+        size_t row_index = rows_read++;
+        rows_read_total.inc();
+        m_timer.lap(m_report.parse);
+        if (row_index < resume_row)
+        {
+          continue;
+        }
+
+        if (m_checkpoint && row_index > resume_row && (row_index - resume_row) % CHECKPOINT_SEGMENT_ROWS == 0)
+        {
+          m_checkpoint->close(row_index);
+        }
 
-        // Proceed with transformations
         try
         {
-          for (const auto &transformer_ptr : *m_transformers)
-          {
-            transformer_ptr->Operation(row);
-          }
-          publish(row, old_count);
+          process_row(row, row_count, old_count, filtered_counts);
         }
         catch (...)
         {
           std::exception_ptr e = std::current_exception();
+          m_timer.lap(m_report.failed);
+          row_errors_total.inc();
+          ++m_report.rows_failed;
           ss.str("Error in row: ");
           ss << row;
           if (exc_count == 0)
@@ -241,6 +390,7 @@ void CsvProcessor::handle(PollResult d)
           if (++exc_count > 13)
           {
             Logging::ERROR("To many exceptions in file '" + d.get() + "'", m_name);
+            read_failed = true;
             break;
           }
         }
@@ -248,10 +398,82 @@ void CsvProcessor::handle(PollResult d)
     }
     catch (...)
     {
+      // Failed while reading or parsing the file
+      m_timer.lap(m_report.parse);
       Logging::ERROR("Unable to load file '" + d.get() + "'", m_name);
+      read_failed = true;
+    }
+
+    // Wait until all messages of this file are durable
+    try
+    {
+      TRACE_SPAN("flush");
+      m_sink->flush();
+    }
+    catch (const std::exception &e)
+    {
+      Logging::ERROR(e.what(), m_name);
+    }
+    m_timer.lap(m_report.flush);
+
+    if (m_sink->outstanding() > 0)
+    {
+      Logging::ERROR(std::to_string(m_sink->outstanding()) + " message(s) were not delivered", m_name);
+    }
+    // With checkpoints the failed messages are replayed after a restart, here they are only logged
+    size_t failed = m_sink->take_failed();
+    if (failed > 0)
+    {
+      Logging::ERROR(std::to_string(failed) + " message(s) of '" + file_path + "' failed", m_name);
+    }
+
+    if (file.bad() || !file.error().empty())
+    {
+      Logging::ERROR("Unable to read file '" + d.get() + "': " + file.error(), m_name);
+      read_failed = true;
+    }
+
+    bool done = !read_failed;
+    if (checkpoint)
+    {
+      checkpoint->close(rows_read);
+      done = done && checkpoint->complete();
+      m_checkpoint = nullptr;
+    }
+    m_report.status = done ? "done" : "incomplete";
+
+    if (done)
+    {
+      // Remove the sidecar first: a stale one would skip rows of a new file with the same name
+      if (checkpoint)
+      {
+        checkpoint->remove();
+      }
+      rename(tmp_file_path.c_str(), std::string(file_path + "_done").c_str());
+      files_done_total.inc();
+    }
+    else
+    {
+      files_incomplete_total.inc();
+      // Keep the file in progress, the next start resumes it from the checkpoint
+      if (read_failed)
+      {
+        Logging::ERROR("Not all rows of '" + file_path + "' were read. Keeping it for a resume after restart", m_name);
+      }
+      else
+      {
+        Logging::ERROR("Not all messages of '" + file_path + "' were delivered. Keeping it for a resume after restart", m_name);
+      }
     }
 
-    rename(tmp_file_path.c_str(), std::string(d.get() + "_done").c_str());
+    if (m_report_writer)
+    {
+      m_report.rows_skipped = std::min(rows_read, resume_row);
+      m_report.rows_read = rows_read - m_report.rows_skipped;
+      m_report.rows_filtered = std::accumulate(filtered_counts.begin(), filtered_counts.end(), old_count);
+      m_report.total = FileReport::Clock::now() - started;
+      m_report_writer->write(m_report);
+    }
   }
 
   ss.str("");
@@ -261,26 +483,283 @@ void CsvProcessor::handle(PollResult d)
 
   if (old_count > 0)
   {
-    ss << ". Ignored " << old_count << " events because they were older than " << m_max_age_config->second << " days";
+    count_filtered("max_age", old_count);
+    ss << ". Ignored " << old_count << " events because they were older than " << m_max_age_filter->days() << " days";
   }
-  Logging::INFO(ss.str(), m_name);
 
-  /*
-  Why do we protect writes to shared var even if it is atomic?
-  There could be problems if write to shared variable happens between checking it in predicate and waiting on condition. Consider the following:
-  1. Waiting thread (e.g. LogProcessor) wakes up spuriously, aquires mutex, checks predicate and evaluates it to false, so it must wait in cv again.
-  2. Controlling thread (e.g. CsvProcessor) set the shared variable to true (or 0 in case of our count).
-  3. Controlling thread sends notification, which is not received by anybody, because there is no thread waiting on condition variable
-  4. Waiting thread waits on condition variable. Since notification was already sent, it would wait until the next spurious wakeup, or next time
-  when controlling thread sends notification. Potentially waiting indefinetly.
-  */
+  for (size_t i = 0; i < filtered_counts.size(); ++i)
   {
-    std::unique_lock lock(*m_log_cv_mutex);
-    m_active_processors->fetch_add(-1);
+    if (filtered_counts[i] > 0)
+    {
+      count_filtered((*m_filters)[i]->name(), filtered_counts[i]);
+      ss << ". Filter '" << (*m_filters)[i]->name() << "' dropped " << filtered_counts[i] << " events";
+    }
   }
-  m_log_cv->notify_all();
+  Logging::INFO(ss.str(), m_name);
+
+  file_duration.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count());
 };
 
+void CsvProcessor::handle_stream(const std::string &path)
+{
+  bool is_stdin = !path.compare("-");
+
+  if (!m_sink)
+  {
+    m_sink = m_sink_factory->create(m_name);
+  }
+  if (!m_arena)
+  {
+    m_arena = new RowArena();
+  }
+  m_timer.start(false);
+
+  // A named pipe is reopened for the next writer, until shutdown
+  do
+  {
+    int fd = is_stdin ? STDIN_FILENO : open(path.c_str(), O_RDONLY | O_NONBLOCK);
+    if (fd < 0)
+    {
+      Logging::ERROR("Unable to open '" + path + "': " + strerror(errno), m_name);
+      kill(getpid(), SIGINT);
+      return;
+    }
+
+    Logging::INFO("Streaming from " + (is_stdin ? std::string("stdin") : "'" + path + "'"), m_name);
+    stream_rows(fd);
+
+    if (!is_stdin)
+    {
+      close(fd);
+    }
+  } while (!is_stdin && !m_sig_channel->m_shutdown_requested.load());
+
+  if (is_stdin && !m_sig_channel->m_shutdown_requested.load())
+  {
+    Logging::INFO("End of stdin. Shutting down", m_name);
+    kill(getpid(), SIGINT);
+  }
+}
+
+void CsvProcessor::stream_rows(int fd)
+{
+  size_t rows_read = 0;
+  size_t unflushed = 0;
+  size_t row_count = 0;
+  size_t old_count = 0;
+  std::vector<size_t> filtered_counts(m_filters ? m_filters->size() : 0, 0);
+  auto last_flush = std::chrono::steady_clock::now();
+
+  // Rows before flushed_rows were flushed. Rows lost since then can't be replayed, only logged.
+  size_t flushed_rows = 0;
+  auto flush = [&]()
+  {
+    if (!flush_sink(unflushed))
+    {
+      Logging::ERROR("Rows " + std::to_string(flushed_rows + 1) + " to " + std::to_string(rows_read) + " of the stream were not all published", m_name);
+    }
+    flushed_rows = rows_read;
+    last_flush = std::chrono::steady_clock::now();
+  };
+
+  /* Flush rows that would otherwise wait for the next ones while the writer is idle. The max age
+   * cutoff is also refreshed here: it is otherwise only refreshed every MAX_AGE_REFRESH_ROWS rows,
+   * which may take hours on a quiet stream. */
+  PipeStreamBuf buf(fd, STREAM_IDLE_MS, [&]()
+                    {
+                      if (m_sig_channel->m_shutdown_requested.load())
+                      {
+                        return false;
+                      }
+                      if (m_max_age_filter)
+                      {
+                        m_max_age_filter->refresh();
+                      }
+                      if (unflushed > 0 && std::chrono::steady_clock::now() - last_flush >= m_stream_flush_interval)
+                      {
+                        flush();
+                      }
+                      return true; });
+  std::istream stream(&buf);
+
+  for (auto &row : CSVRange(stream, true, m_projection, m_arena))
+  {
+    ++rows_read;
+    rows_read_total.inc();
+
+    try
+    {
+      if (process_row(row, row_count, old_count, filtered_counts))
+      {
+        ++unflushed;
+      }
+    }
+    catch (...)
+    {
+      std::exception_ptr e = std::current_exception();
+      row_errors_total.inc();
+      std::stringstream ss;
+      ss << "Error in row: " << row << ": " << (e ? Util::what(e) : "null");
+      Logging::ERROR(ss.str(), m_name);
+    }
+
+    bool interval_elapsed = (rows_read % STREAM_CLOCK_ROWS) == 0 && std::chrono::steady_clock::now() - last_flush >= m_stream_flush_interval;
+    if (unflushed >= m_stream_flush_rows || (unflushed > 0 && interval_elapsed))
+    {
+      flush();
+    }
+  }
+  flush();
+
+  if (!buf.error().empty())
+  {
+    Logging::ERROR("Unable to read stream: " + buf.error(), m_name);
+  }
+
+  std::stringstream ss;
+  ss << "End of stream after " << rows_read << " rows";
+  if (old_count > 0)
+  {
+    count_filtered("max_age", old_count);
+    ss << ". Ignored " << old_count << " events because they were older than " << m_max_age_filter->days() << " days";
+  }
+  for (size_t i = 0; i < filtered_counts.size(); ++i)
+  {
+    if (filtered_counts[i] > 0)
+    {
+      count_filtered((*m_filters)[i]->name(), filtered_counts[i]);
+      ss << ". Filter '" << (*m_filters)[i]->name() << "' dropped " << filtered_counts[i] << " events";
+    }
+  }
+  Logging::INFO(ss.str(), m_name);
+}
+
+void CsvProcessor::handle_batch(const PollResult &d)
+{
+  TRACE_SPAN("CsvProcessor::handle_batch");
+  if (!m_sink)
+  {
+    m_sink = m_sink_factory->create(m_name);
+  }
+  if (!m_arena)
+  {
+    m_arena = new RowArena();
+  }
+  m_timer.start(false);
+
+  if (m_batch_unflushed == 0)
+  {
+    m_last_batch_flush = std::chrono::steady_clock::now();
+  }
+
+  size_t rows_read = 0;
+  size_t row_count = 0;
+  size_t old_count = 0;
+  std::vector<size_t> filtered_counts(m_filters ? m_filters->size() : 0, 0);
+
+  MemoryStreamBuf buf(d.data()->data(), d.data()->size());
+  std::istream stream(&buf);
+  for (auto &row : CSVRange(stream, true, m_projection, m_arena))
+  {
+    ++rows_read;
+    rows_read_total.inc();
+
+    try
+    {
+      if (process_row(row, row_count, old_count, filtered_counts))
+      {
+        ++m_batch_unflushed;
+      }
+    }
+    catch (...)
+    {
+      std::exception_ptr e = std::current_exception();
+      row_errors_total.inc();
+      std::stringstream ss;
+      ss << "Error in row of " << d.get() << ": " << row << ": " << (e ? Util::what(e) : "null");
+      Logging::ERROR(ss.str(), m_name);
+    }
+  }
+
+  if (d.failed() && (m_unflushed_connections.empty() || m_unflushed_connections.back() != d.failed()))
+  {
+    m_unflushed_connections.push_back(d.failed());
+  }
+  // Like streams, batches are flushed every m_stream_flush_rows messages or m_stream_flush_interval
+  if (m_batch_unflushed >= m_stream_flush_rows || std::chrono::steady_clock::now() - m_last_batch_flush >= m_stream_flush_interval)
+  {
+    flush_batches();
+  }
+
+  if (old_count > 0)
+  {
+    count_filtered("max_age", old_count);
+  }
+  for (size_t i = 0; i < filtered_counts.size(); ++i)
+  {
+    if (filtered_counts[i] > 0)
+    {
+      count_filtered((*m_filters)[i]->name(), filtered_counts[i]);
+    }
+  }
+  LOG_DEBUG("Processed " + std::to_string(rows_read) + " row(s) of " + d.get(), m_name);
+}
+
+void CsvProcessor::flush_batches()
+{
+  if (!flush_sink(m_batch_unflushed))
+  {
+    // Closes the connections, so their clients learn that rows were lost
+    for (auto &failed : m_unflushed_connections)
+    {
+      failed->store(true);
+    }
+  }
+  m_unflushed_connections.clear();
+}
+
+void CsvProcessor::idle()
+{
+  // No batch for a while: don't let the last ones wait for more
+  if (m_sink && (m_batch_unflushed > 0 || !m_unflushed_connections.empty()))
+  {
+    flush_batches();
+  }
+}
+
+bool CsvProcessor::flush_sink(size_t &unflushed)
+{
+  bool delivered = true;
+  // Streams can't be resumed, the flush is their checkpoint: all rows so far are durable
+  try
+  {
+    TRACE_SPAN("flush");
+    m_sink->flush();
+  }
+  catch (const std::exception &e)
+  {
+    Logging::ERROR(e.what(), m_name);
+    delivered = false;
+  }
+
+  if (m_sink->outstanding() > 0)
+  {
+    Logging::ERROR(std::to_string(m_sink->outstanding()) + " message(s) were not delivered", m_name);
+    delivered = false;
+  }
+
+  // Failed deliveries and dropped messages are done as well, they don't count as outstanding
+  size_t failed = m_sink->take_failed();
+  if (failed > 0)
+  {
+    Logging::ERROR(std::to_string(failed) + " message(s) failed", m_name);
+    delivered = false;
+  }
+  LOG_DEBUG("Flushed " + std::to_string(unflushed) + " row(s)", m_name);
+  unflushed = 0;
+  return delivered;
+}
+
 AbstractProcessor *CsvProcessor::clone() const
 {
   return new CsvProcessor(*this);
@@ -293,6 +772,14 @@ CsvProcessorBuilder CsvProcessor::builder(std::string name)
 
 void CsvProcessor::clean()
 {
+  if (m_sink && (m_batch_unflushed > 0 || !m_unflushed_connections.empty()))
+  {
+    flush_batches();
+  }
+  delete m_sink;
+  m_sink = nullptr;
+  delete m_arena;
+  m_arena = nullptr;
 }
 
 CsvProcessor::~CsvProcessor()
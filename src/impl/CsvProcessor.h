@@ -4,10 +4,17 @@
 #include "AbstractProcessor.h"
 #include "impl/PollResult.h"
 #include "config/SchemaConfig.h"
-#include <librdkafka/rdkafkacpp.h>
+#include "config/Profile.h"
+#include "filters/MaxAgeFilter.h"
+#include "filters/RowFilter.h"
+#include "impl/FileCheckpoint.h"
+#include "impl/FileReport.h"
+#include "sinks/Sink.h"
+#include "csv/RowArena.h"
 
 #include <avro/ValidSchema.hh>
 #include <avro/Generic.hh>
+#include <optional>
 
 class CsvProcessorBuilder;
 
@@ -16,11 +23,52 @@ class CsvProcessor : public AbstractProcessor
 private:
   void handle(PollResult d) override;
   void clean() override;
-  void publish(CSVRow &row, size_t &old_count);
-  RdKafka::Producer *m_kafka_producer;
-  std::map<std::string, SchemaConfig> *m_schemas;
-  ssize_t serialize(avro::ValidSchema schema, const int32_t schema_id, const avro::GenericDatum datum, std::vector<char> &out, std::string &errstr);
-  std::pair<std::string, int> *m_max_age_config;
+  void handle_stream(const std::string &path);
+  void handle_batch(const PollResult &d);
+  void flush_batches();
+  void idle() override;
+  void stream_rows(int fd);
+  bool flush_sink(size_t &unflushed);
+  void publish(CSVRow &row);
+  bool process_row(CSVRow &row, size_t &row_count, size_t &old_count, std::vector<size_t> &filtered_counts);
+  bool apply_filters(CSVRow &row, std::vector<size_t> &filtered_counts);
+  bool use_profile(const std::string &profile_name);
+  void use_route(const std::string &file_path);
+
+  // Shared by all processors. The sink itself is created on the processor's thread.
+  SinkFactory *m_sink_factory = nullptr;
+  Sink *m_sink = nullptr;
+
+  // Storage of the current row, created on the processor's thread
+  RowArena *m_arena = nullptr;
+  // Profiles by name, the one of the current file is selected by use_profile()
+  std::map<std::string, Profile> *m_profiles = nullptr;
+  Profile *m_profile = nullptr;
+  const std::map<std::string, SchemaConfig> *m_schemas = nullptr;
+  ssize_t serialize(const avro::ValidSchema &schema, const int32_t schema_id, const avro::GenericDatum &datum, std::vector<char> &out, std::string &errstr);
+  std::optional<MaxAgeFilter> m_max_age_filter;
+  std::vector<std::unique_ptr<RowFilter>> *m_filters = nullptr;
+  const std::set<std::string> *m_projection = nullptr;
+
+  // Resume files from the checkpoint sidecar of a previous run
+  bool m_checkpoints = false;
+  FileCheckpoint *m_checkpoint = nullptr;
+
+  // Report of the current file, stages are only timed when there is a report writer
+  FileReportWriter *m_report_writer = nullptr;
+  FileReport m_report;
+  StageTimer m_timer;
+
+  // Streaming input (stdin or a named pipe) instead of files, flushed every m_stream_flush_rows
+  // messages or m_stream_flush_interval. Socket batches are flushed the same way.
+  bool m_streaming = false;
+  size_t m_stream_flush_rows = 0;
+  std::chrono::milliseconds m_stream_flush_interval{0};
+
+  // Messages of socket batches since the last flush, and the failure flags of their connections
+  size_t m_batch_unflushed = 0;
+  std::chrono::steady_clock::time_point m_last_batch_flush;
+  std::vector<std::shared_ptr<std::atomic<bool>>> m_unflushed_connections;
 
 public:
   CsvProcessor(std::string name_, std::shared_ptr<SignalChannel> sig_channel_);
@@ -5,84 +5,69 @@ CsvProcessorBuilder::CsvProcessorBuilder(std::string name) : m_name(name)
 {
 }
 
-CsvProcessorBuilder &CsvProcessorBuilder::with_transformers(std::vector<std::unique_ptr<AbstractTransformer>> *t)
+CsvProcessorBuilder &CsvProcessorBuilder::with_sink_factory(SinkFactory *f)
 {
-    m_transformers = t;
+    m_sink_factory = f;
     return *this;
 }
 
-CsvProcessorBuilder &CsvProcessorBuilder::with_active_processors_counter(std::atomic<size_t> *c)
+CsvProcessorBuilder &CsvProcessorBuilder::with_checkpoints(bool c)
 {
-    m_active_processors = c;
+    m_checkpoints = c;
     return *this;
 }
 
-CsvProcessorBuilder &CsvProcessorBuilder::with_logging_cv(std::condition_variable *cv)
+CsvProcessorBuilder &CsvProcessorBuilder::with_profiles(std::map<std::string, Profile> *p)
 {
-    m_log_cv = cv;
+    m_profiles = p;
     return *this;
 }
 
-CsvProcessorBuilder &CsvProcessorBuilder::with_logging_mutex(std::mutex *m)
-{
-    m_log_cv_mutex = m;
-    return *this;
-}
-
-CsvProcessorBuilder &CsvProcessorBuilder::with_kafka_producer(RdKafka::Producer *kp)
+CsvProcessorBuilder &CsvProcessorBuilder::with_sig_channel(std::shared_ptr<SignalChannel> sc)
 {
-    m_kafka_producer = kp;
+    m_sig_channel = sc;
     return *this;
 }
 
-CsvProcessorBuilder &CsvProcessorBuilder::with_schemas(std::map<std::string, SchemaConfig> *s)
+CsvProcessorBuilder &CsvProcessorBuilder::with_report_writer(FileReportWriter *w)
 {
-    m_schemas = s;
+    m_report_writer = w;
     return *this;
 }
 
-CsvProcessorBuilder &CsvProcessorBuilder::with_sig_channel(std::shared_ptr<SignalChannel> sc)
+CsvProcessorBuilder &CsvProcessorBuilder::with_streaming(size_t flush_rows, int flush_interval_ms)
 {
-    m_sig_channel = sc;
+    m_streaming = true;
+    m_stream_flush_rows = flush_rows;
+    m_stream_flush_interval_ms = flush_interval_ms;
     return *this;
 }
 
-CsvProcessorBuilder &CsvProcessorBuilder::with_drop_max_age(std::pair<std::string, int> *p)
+CsvProcessorBuilder &CsvProcessorBuilder::with_batch_flush(size_t flush_rows, int flush_interval_ms)
 {
-    m_max_age = p;
+    m_stream_flush_rows = flush_rows;
+    m_stream_flush_interval_ms = flush_interval_ms;
     return *this;
 }
 
 std::unique_ptr<CsvProcessor> CsvProcessorBuilder::build() const
 {
-    if (!m_transformers)
-    {
-        throw std::runtime_error("No transformers provided");
-    }
-
-    if (!m_active_processors)
-    {
-        throw std::runtime_error("No active processors counter provided");
-    }
-
-    if (!m_log_cv)
-    {
-        throw std::runtime_error("No log cv provided");
-    }
-
-    if (!m_log_cv_mutex)
+    if (!m_profiles || m_profiles->empty())
     {
-        throw std::runtime_error("No log cv mutex provided");
+        throw std::runtime_error("No profiles provided");
     }
 
-    if (!m_kafka_producer)
+    if (!m_sink_factory)
     {
-        throw std::runtime_error("No kafka producer provided");
+        throw std::runtime_error("No sink factory provided");
     }
 
-    if (m_schemas->empty())
+    for (const auto &[profile_name, profile] : *m_profiles)
     {
-        throw std::runtime_error("No schemas provided");
+        if (profile.schemas.empty())
+        {
+            throw std::runtime_error("No schemas provided for profile '" + profile_name + "'");
+        }
     }
 
     if (!m_sig_channel)
@@ -91,17 +76,13 @@ std::unique_ptr<CsvProcessor> CsvProcessorBuilder::build() const
     }
 
     std::unique_ptr<CsvProcessor> processor = std::make_unique<CsvProcessor>(m_name, m_sig_channel);
-    processor->m_transformers = m_transformers;
-    processor->m_active_processors = m_active_processors;
-    processor->m_log_cv = m_log_cv;
-    processor->m_log_cv_mutex = m_log_cv_mutex;
-    processor->m_kafka_producer = m_kafka_producer;
-    processor->m_schemas = m_schemas;
-
-    if (m_max_age)
-    {
-        processor->m_max_age_config = m_max_age;
-    }
+    processor->m_sink_factory = m_sink_factory;
+    processor->m_checkpoints = m_checkpoints;
+    processor->m_profiles = m_profiles;
+    processor->m_report_writer = m_report_writer;
+    processor->m_streaming = m_streaming;
+    processor->m_stream_flush_rows = m_stream_flush_rows;
+    processor->m_stream_flush_interval = std::chrono::milliseconds(m_stream_flush_interval_ms);
 
     return processor;
 }
\ No newline at end of file
@@ -7,26 +7,25 @@ class CsvProcessorBuilder
 {
 private:
     std::string m_name;
-    std::vector<std::unique_ptr<AbstractTransformer>> *m_transformers = nullptr;
-    std::atomic<size_t> *m_active_processors = nullptr;
-    std::condition_variable *m_log_cv = nullptr;
-    std::mutex *m_log_cv_mutex = nullptr;
-    RdKafka::Producer *m_kafka_producer;
+    SinkFactory *m_sink_factory = nullptr;
+    bool m_checkpoints = false;
     std::string m_kafka_topic;
     std::shared_ptr<SignalChannel> m_sig_channel;
-    std::map<std::string, SchemaConfig> *m_schemas;
-    std::pair<std::string, int> *m_max_age;
+    std::map<std::string, Profile> *m_profiles = nullptr;
+    FileReportWriter *m_report_writer = nullptr;
+    bool m_streaming = false;
+    size_t m_stream_flush_rows = 0;
+    int m_stream_flush_interval_ms = 0;
 
 public:
     CsvProcessorBuilder(std::string name);
-    CsvProcessorBuilder &with_transformers(std::vector<std::unique_ptr<AbstractTransformer>> *t);
-    CsvProcessorBuilder &with_active_processors_counter(std::atomic<size_t> *c);
-    CsvProcessorBuilder &with_logging_cv(std::condition_variable *cv);
-    CsvProcessorBuilder &with_logging_mutex(std::mutex *m);
-    CsvProcessorBuilder &with_kafka_producer(RdKafka::Producer *kp);
-    CsvProcessorBuilder &with_schemas(std::map<std::string, SchemaConfig> *s);
+    CsvProcessorBuilder &with_sink_factory(SinkFactory *f);
+    CsvProcessorBuilder &with_checkpoints(bool c);
+    CsvProcessorBuilder &with_profiles(std::map<std::string, Profile> *p);
     CsvProcessorBuilder &with_sig_channel(std::shared_ptr<SignalChannel> sc);
-    CsvProcessorBuilder &with_drop_max_age(std::pair<std::string, int> *p);
+    CsvProcessorBuilder &with_report_writer(FileReportWriter *w);
+    CsvProcessorBuilder &with_streaming(size_t flush_rows, int flush_interval_ms);
+    CsvProcessorBuilder &with_batch_flush(size_t flush_rows, int flush_interval_ms);
     std::unique_ptr<CsvProcessor> build() const;
 };
 
@@ -1,6 +1,7 @@
 #ifdef __linux__
 #include "DirectoryPoller.h"
 #include "Util.h"
+#include "trace/Trace.h"
 #include <stdlib.h> // for srand(), rand()
 #include <thread>
 #include <sstream>
@@ -11,6 +12,8 @@
 #include <sys/inotify.h>
 #include <sys/types.h>
 #include <unistd.h> // for read()
+#include <fcntl.h>  // for F_SETLEASE
+#include <cerrno>
 #include <filesystem>
 #include <iostream>
 #include <signal.h>
@@ -20,74 +23,170 @@
 #define EVENT_SIZE (sizeof(struct inotify_event))
 #define BUF_LEN (1024 * (EVENT_SIZE + 16))
 
-DirectoryPoller::DirectoryPoller(std::string name, std::string dir_to_watch, std::shared_ptr<SignalChannel> sig_channel) : AbstractPoller(name, sig_channel), m_dir_to_watch(dir_to_watch)
+DirectoryPoller::DirectoryPoller(std::string name, std::vector<DirectoryConfig> directories, std::shared_ptr<SignalChannel> sig_channel) : AbstractPoller(name, sig_channel), m_directories(directories)
 {
-  m_last_files = list_files();
-  for (const std::string &f : m_last_files)
+  for (const DirectoryConfig &directory : m_directories)
   {
-    if (should_add_file(f, true))
+    for (const std::string &f : list_files(directory))
     {
-      Logging::INFO("Adding file '" + f + "'", m_name);
-      m_file_paths.emplace_back(f);
+      if (should_add_file(f, true))
+      {
+        Logging::INFO("Adding file '" + f + "'", m_name);
+        m_file_paths.emplace_back(f, directory.profile);
+      }
     }
   }
 }
 
 bool DirectoryPoller::init_dir_watch()
 {
-  Logging::INFO("Watching '" + m_dir_to_watch + "'", m_name);
-
   m_fd = inotify_init();
   if (m_fd < 0)
   {
     perror("inotify_init");
+    return false;
+  }
+
+  for (const DirectoryConfig &directory : m_directories)
+  {
+    if (!add_watch(directory))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Watch the directory and, if it is recursive, all of its subdirectories.
+ */
+bool DirectoryPoller::add_watch(const DirectoryConfig &directory)
+{
+  std::vector<std::string> paths = {directory.path};
+  if (directory.recursive)
+  {
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(directory.path, ec))
+    {
+      if (entry.is_directory())
+      {
+        paths.emplace_back(entry.path());
+      }
+    }
+  }
+
+  for (const std::string &path : paths)
+  {
+    int wd = inotify_add_watch(m_fd, path.c_str(), IN_CREATE | IN_MOVE | IN_CLOSE);
+    if (wd < 0)
+    {
+      perror("inotify_add_watch");
+      return false;
+    }
+    Logging::INFO("Watching '" + path + "'", m_name);
+    m_watches[wd] = DirectoryConfig{path, directory.recursive, directory.profile};
+  }
+  return true;
+}
+
+/**
+ * Watch a new subdirectory of a recursive directory and add the files that are already in it.
+ * Files still open for writing are left to their IN_CLOSE event. A file closed between the
+ * watch and the listing is added twice, the second attempt finds it renamed.
+ */
+void DirectoryPoller::add_subdirectory(const DirectoryConfig &subdirectory)
+{
+  if (!add_watch(subdirectory))
+  {
+    Logging::ERROR("Unable to watch '" + subdirectory.path + "', new files in it are picked up at the next start", m_name);
+  }
+
+  for (const std::string &f : list_files(subdirectory))
+  {
+    if (should_add_file(f, false) && !open_for_writing(f))
+    {
+      Logging::INFO("Adding file '" + f + "'", m_name);
+      m_file_paths.emplace_back(f, subdirectory.profile);
+    }
   }
+}
 
-  m_wd = inotify_add_watch(m_fd, m_dir_to_watch.c_str(), IN_CREATE | IN_MOVE | IN_CLOSE);
+/**
+ * A read lease can't be taken while any process has the file open for writing. Without the
+ * permission to take one (not the file's owner), the file counts as complete.
+ */
+bool DirectoryPoller::open_for_writing(const std::string &path)
+{
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    return false;
+  }
+  bool writing = fcntl(fd, F_SETLEASE, F_RDLCK) != 0 && errno == EAGAIN;
+  fcntl(fd, F_SETLEASE, F_UNLCK);
+  close(fd);
+  return writing;
 }
 
 bool DirectoryPoller::should_add_file(const std::string &f, bool starting_up)
 {
-  return (starting_up || !Util::str_ends_with(f.c_str(), "_inprogress")) && !Util::str_ends_with(f.c_str(), "_done");
+  return (starting_up || !Util::str_ends_with(f.c_str(), "_inprogress")) && !Util::str_ends_with(f.c_str(), "_done") && !Util::str_ends_with(f.c_str(), "_checkpoint") && !Util::str_ends_with(f.c_str(), "_checkpoint_tmp");
 }
 
-std::set<std::string> DirectoryPoller::list_files()
+std::set<std::string> DirectoryPoller::list_files(const DirectoryConfig &directory)
 {
   std::set<std::string> files;
-  for (const auto &entry : std::filesystem::directory_iterator(m_dir_to_watch))
+  if (directory.recursive)
   {
-    files.emplace(entry.path());
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(directory.path, ec))
+    {
+      if (!entry.is_directory())
+      {
+        files.emplace(entry.path());
+      }
+    }
+  }
+  else
+  {
+    for (const auto &entry : std::filesystem::directory_iterator(directory.path))
+    {
+      if (!entry.is_directory())
+      {
+        files.emplace(entry.path());
+      }
+    }
   }
   return files;
 }
 
 PollResult DirectoryPoller::poll()
 {
-  std::stringstream ss;
-  ss << "Polling";
-  Logging::DEBUG(ss.str(), m_name);
+  TRACE_SPAN("DirectoryPoller::poll");
+  LOG_DEBUG("Polling", m_name);
 
   // Do not wait for events if we already have files
   if (!m_file_paths.empty())
   {
-    std::string p = m_file_paths.back();
+    PollResult p = m_file_paths.back();
     m_file_paths.pop_back();
-    return PollResult(p);
+    return p;
   }
 
-  if (m_fd == -1 || m_wd == -1)
+  if (m_fd == -1)
   {
     if (!init_dir_watch())
     {
-      Logging::ERROR("Unable to init directory watch for '" + m_dir_to_watch + "'", m_name);
+      Logging::ERROR("Unable to init directory watch", m_name);
       kill(getpid(), SIGINT);
+      return PollResult("");
     }
   }
 
   // Non-blocking
   int return_value;
   fd_set descriptors;
-  struct timeval time_to_wait;
+  struct timeval time_to_wait = {0, 0};
   FD_ZERO(&descriptors);
   FD_SET(m_fd, &descriptors);
 
@@ -114,8 +213,19 @@ PollResult DirectoryPoller::poll()
     while (i < length)
     {
       struct inotify_event *event = (struct inotify_event *)&buffer[i];
-      if (event->len)
+      auto watch = m_watches.find(event->wd);
+      if (event->mask & IN_IGNORED)
+      {
+        // The directory was removed
+        if (watch != m_watches.end())
+        {
+          Logging::INFO("No longer watching '" + watch->second.path + "'", m_name);
+          m_watches.erase(watch);
+        }
+      }
+      else if (event->len && watch != m_watches.end())
       {
+        const DirectoryConfig directory = watch->second;
         if (event->mask & IN_CREATE)
         {
           if (event->mask & IN_ISDIR)
@@ -124,6 +234,12 @@ PollResult DirectoryPoller::poll()
             s += event->name;
             s += " was created.";
             Logging::INFO(s, m_name);
+
+            if (directory.recursive)
+            {
+              // Files written before the watch was set up don't cause events
+              add_subdirectory(DirectoryConfig{directory.path + "/" + event->name, true, directory.profile});
+            }
           }
           else
           {
@@ -133,6 +249,14 @@ PollResult DirectoryPoller::poll()
             Logging::INFO(s, m_name);
           }
         }
+        else if ((event->mask & IN_MOVED_TO) && (event->mask & IN_ISDIR))
+        {
+          if (directory.recursive)
+          {
+            // A directory moved in as a whole: no IN_CLOSE will follow for its files
+            add_subdirectory(DirectoryConfig{directory.path + "/" + event->name, true, directory.profile});
+          }
+        }
         else if (event->mask & (IN_CLOSE))
         {
           if (event->mask & IN_ISDIR)
@@ -144,13 +268,13 @@ PollResult DirectoryPoller::poll()
           }
           else
           {
-            std::string file_name(m_dir_to_watch);
+            std::string file_name(directory.path);
             file_name += "/";
             file_name += event->name;
 
             if (should_add_file(file_name, false))
             {
-              m_file_paths.emplace_back(file_name);
+              m_file_paths.emplace_back(file_name, directory.profile);
               std::string s("The file ");
               s += file_name;
               s += " was added.";
@@ -169,9 +293,9 @@ PollResult DirectoryPoller::poll()
   }
   else
   {
-    std::string p = m_file_paths.back();
+    PollResult p = m_file_paths.back();
     m_file_paths.pop_back();
-    return PollResult(p);
+    return p;
   }
 }
 
@@ -191,7 +315,10 @@ void DirectoryPoller::clean()
 
 DirectoryPoller::~DirectoryPoller()
 {
-  (void)inotify_rm_watch(m_fd, m_wd);
+  for (const auto &[wd, directory] : m_watches)
+  {
+    (void)inotify_rm_watch(m_fd, wd);
+  }
   (void)close(m_fd);
 }
 #endif
\ No newline at end of file
@@ -7,11 +7,13 @@
 #include <string>
 #include <vector>
 #include <set>
+#include <map>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
 #include "AbstractPoller.h"
 #include "impl/PollResult.h"
+#include "config/DirectoryConfig.h"
 
 class DirectoryPollerBuilder;
 
@@ -21,19 +23,22 @@ private:
   PollResult poll() override;
   void clean() override;
   bool init_dir_watch();
-  std::set<std::string> list_files();
+  bool add_watch(const DirectoryConfig &directory);
+  void add_subdirectory(const DirectoryConfig &subdirectory);
+  bool open_for_writing(const std::string &path);
+  std::set<std::string> list_files(const DirectoryConfig &directory);
   bool should_add_file(const std::string &f, bool starting_up);
-  std::string m_dir_to_watch;
-  std::vector<std::string> m_file_paths;
+  std::vector<DirectoryConfig> m_directories;
+  std::vector<PollResult> m_file_paths;
   int m_fd = -1;
-  int m_wd = -1;
-  std::set<std::string> m_last_files;
+  // Watched directories (subdirectories of recursive ones included) by watch descriptor
+  std::map<int, DirectoryConfig> m_watches;
   std::atomic<bool> *m_data_available;
   std::condition_variable *m_queue_cv;
   std::mutex *m_queue_cv_mutex;
 
 public:
-  DirectoryPoller(std::string name, std::string dir_to_watch, std::shared_ptr<SignalChannel> sig_channel);
+  DirectoryPoller(std::string name, std::vector<DirectoryConfig> directories, std::shared_ptr<SignalChannel> sig_channel);
   ~DirectoryPoller() override;
   AbstractPoller *clone() const override;
 
@@ -7,7 +7,13 @@ DirectoryPollerBuilder::DirectoryPollerBuilder(std::string name) : m_name(name)
 
 DirectoryPollerBuilder &DirectoryPollerBuilder::with_directory(std::string p)
 {
-    m_dir_to_watch = p;
+    m_directories.push_back(DirectoryConfig{p, false, ""});
+    return *this;
+}
+
+DirectoryPollerBuilder &DirectoryPollerBuilder::with_directory(DirectoryConfig d)
+{
+    m_directories.push_back(d);
     return *this;
 }
 
@@ -20,7 +26,7 @@ DirectoryPollerBuilder &DirectoryPollerBuilder::with_sig_channel(std::shared_ptr
 DirectoryPoller DirectoryPollerBuilder::build()
 {
 
-    if (m_dir_to_watch.empty())
+    if (m_directories.empty())
     {
         throw std::runtime_error("No directory must be provided");
     }
@@ -30,7 +36,7 @@ DirectoryPoller DirectoryPollerBuilder::build()
         throw std::runtime_error("No signal channel provided");
     }
 
-    DirectoryPoller poller = DirectoryPoller(m_name, m_dir_to_watch, m_sig_channel);
+    DirectoryPoller poller = DirectoryPoller(m_name, m_directories, m_sig_channel);
 
     return poller;
 }
\ No newline at end of file
@@ -8,17 +8,19 @@
 #endif
 
 #include <string>
+#include <vector>
 
 class DirectoryPollerBuilder
 {
 private:
     std::string m_name;
-    std::string m_dir_to_watch;
+    std::vector<DirectoryConfig> m_directories;
     std::shared_ptr<SignalChannel> m_sig_channel;
 
 public:
     DirectoryPollerBuilder(std::string name);
     DirectoryPollerBuilder &with_directory(std::string p);
+    DirectoryPollerBuilder &with_directory(DirectoryConfig d);
     DirectoryPollerBuilder &with_sig_channel(std::shared_ptr<SignalChannel> sc);
     DirectoryPoller build();
 };
@@ -3,6 +3,7 @@
 #include "DirectoryPollerBuilder.h"
 #include "logging/Logging.h"
 #include "Util.h"
+#include "trace/Trace.h"
 #include <stdlib.h> // for srand(), rand()
 #include <thread>
 #include <sstream>
@@ -20,28 +21,49 @@
 #include <algorithm> // for set_difference()
 #include <signal.h>
 
-DirectoryPoller::DirectoryPoller(std::string name, std::string dir_to_watch, std::shared_ptr<SignalChannel> sig_channel) : AbstractPoller(name, sig_channel), m_dir_to_watch(dir_to_watch)
+DirectoryPoller::DirectoryPoller(std::string name, std::vector<DirectoryConfig> directories, std::shared_ptr<SignalChannel> sig_channel) : AbstractPoller(name, sig_channel)
 {
-  m_last_files = list_files();
-  for (const std::string &f : m_last_files)
+  for (const DirectoryConfig &directory : directories)
   {
-    if (should_add_file(f, true))
+    add_directory(directory, true);
+  }
+}
+
+/**
+ * Queue the files of the directory (and its subdirectories, if recursive) and remember them, so
+ * that only files added later are picked up by the watch.
+ */
+void DirectoryPoller::add_directory(const DirectoryConfig &directory, bool starting_up)
+{
+  Watch watch{directory, -1, list_files(directory.path)};
+  for (const std::string &f : watch.last_files)
+  {
+    if (std::filesystem::is_directory(f))
+    {
+      if (directory.recursive)
+      {
+        add_directory(DirectoryConfig{f, true, directory.profile}, starting_up);
+      }
+    }
+    else if (should_add_file(f, starting_up))
     {
       Logging::INFO("Adding file:'" + f + "'", m_name);
-      m_file_paths.emplace_back(f);
+      m_file_paths.emplace_back(f, directory.profile);
     }
   }
+  m_watches.push_back(watch);
 }
 
 bool DirectoryPoller::should_add_file(const std::string &f, bool starting_up)
 {
-  return (starting_up || !Util::str_ends_with(f.c_str(), "_inprogress")) && !Util::str_ends_with(f.c_str(), "_done");
+  return (starting_up || !Util::str_ends_with(f.c_str(), "_inprogress")) && !Util::str_ends_with(f.c_str(), "_done") && !Util::str_ends_with(f.c_str(), "_checkpoint") && !Util::str_ends_with(f.c_str(), "_checkpoint_tmp");
 }
 
-std::set<std::string> DirectoryPoller::list_files()
+std::set<std::string> DirectoryPoller::list_files(const std::string &path)
 {
   std::set<std::string> files;
-  for (const auto &entry : std::filesystem::directory_iterator(m_dir_to_watch))
+  std::error_code ec;
+  for (const auto &entry : std::filesystem::directory_iterator(path, ec))
   {
     files.emplace(entry.path());
   }
@@ -50,24 +72,41 @@ std::set<std::string> DirectoryPoller::list_files()
 
 bool DirectoryPoller::init_dir_watch()
 {
-  Logging::INFO("Watching '" + m_dir_to_watch + "'", m_name);
-
   /* A single kqueue */
   // https://www.freebsd.org/cgi/man.cgi?kqueue
   m_kq = kqueue();
 
-  /* Two kevent structs */
+  /* One kevent struct to receive events */
   m_ke = (struct kevent *)malloc(sizeof(struct kevent));
 
-  /* Initialise the struct for the file descriptor */
-  m_fd = open(m_dir_to_watch.c_str(), O_RDONLY);
-  EV_SET(m_ke, m_fd, EVFILT_VNODE, EV_ADD | EV_CLEAR, NOTE_DELETE | NOTE_RENAME | NOTE_WRITE, 0, NULL);
+  return register_watches();
+}
 
-  /* Register for the event */
-  if (kevent(m_kq, m_ke, 1, NULL, 0, NULL) < 0)
+/**
+ * Register the directories that are not watched yet.
+ */
+bool DirectoryPoller::register_watches()
+{
+  for (Watch &watch : m_watches)
   {
-    perror("kevent");
-    return false;
+    if (watch.fd != -1)
+    {
+      continue;
+    }
+
+    Logging::INFO("Watching '" + watch.directory.path + "'", m_name);
+
+    /* Initialise the struct for the file descriptor */
+    struct kevent ke;
+    watch.fd = open(watch.directory.path.c_str(), O_RDONLY);
+    EV_SET(&ke, watch.fd, EVFILT_VNODE, EV_ADD | EV_CLEAR, NOTE_DELETE | NOTE_RENAME | NOTE_WRITE, 0, NULL);
+
+    /* Register for the event */
+    if (kevent(m_kq, &ke, 1, NULL, 0, NULL) < 0)
+    {
+      perror("kevent");
+      return false;
+    }
   }
 
   return true;
@@ -75,26 +114,26 @@ bool DirectoryPoller::init_dir_watch()
 
 PollResult DirectoryPoller::poll()
 {
-  std::stringstream ss;
-  ss << "Polling";
-  Logging::DEBUG(ss.str(), m_name);
+  TRACE_SPAN("DirectoryPoller::poll");
+  LOG_DEBUG("Polling", m_name);
 
   // Do not wait for events if we already have files
   if (!m_file_paths.empty())
   {
-    std::string p = m_file_paths.back();
+    PollResult p = m_file_paths.back();
     m_file_paths.pop_back();
-    return PollResult(p);
+    return p;
   }
   else
   {
     // Poll for events
-    if (m_fd == -1 || m_kq == -1)
+    if (m_kq == -1)
     {
       if (!init_dir_watch())
       {
-        Logging::ERROR("Unable to init directory watch for '" + m_dir_to_watch + "'", m_name);
+        Logging::ERROR("Unable to init directory watch", m_name);
         kill(getpid(), SIGINT);
+        return PollResult("");
       }
     }
 
@@ -115,42 +154,66 @@ PollResult DirectoryPoller::poll()
     }
     else
     {
+      auto watch = std::find_if(m_watches.begin(), m_watches.end(), [this](const Watch &w)
+                                { return w.fd == static_cast<int>(m_ke->ident); });
+
       switch (m_ke->filter)
       {
       /* File descriptor event: let's examine what happened to the file */
       case EVFILT_VNODE:
-        Logging::DEBUG("Events " + std::to_string(m_ke->fflags) + " on file descriptor " + std::to_string(m_ke->ident), m_name);
+        LOG_DEBUG("Events " + std::to_string(m_ke->fflags) + " on file descriptor " + std::to_string(m_ke->ident), m_name);
+
+        if (watch == m_watches.end())
+        {
+          break;
+        }
 
         if (m_ke->fflags & NOTE_DELETE)
         {
-          Logging::DEBUG("The unlink() system call was called on the file referenced by the descriptor", m_name);
+          LOG_DEBUG("The unlink() system call was called on the file referenced by the descriptor", m_name);
+          Logging::INFO("No longer watching '" + watch->directory.path + "'", m_name);
+          close(watch->fd);
+          m_watches.erase(watch);
+          break;
         }
         if (m_ke->fflags & NOTE_WRITE)
         {
-          Logging::DEBUG("A write occurred on the file referenced by the descriptor", m_name);
-          std::set<std::string> current = list_files();
+          LOG_DEBUG("A write occurred on the file referenced by the descriptor", m_name);
+          std::set<std::string> current = list_files(watch->directory.path);
 
           std::set<std::string> added;
-          // In the end, the set 'added' will contain the current-m_last_files.
-          std::set_difference(current.begin(), current.end(), m_last_files.begin(), m_last_files.end(), std::inserter(added, added.end()));
-          for (const std::string &f : added)
-          {
-            if (should_add_file(f, false))
-            {
-              Logging::INFO("Adding file '" + f + "'", m_name);
-              m_file_paths.emplace_back(f);
-            }
-          }
+          // In the end, the set 'added' will contain the current-last_files.
+          std::set_difference(current.begin(), current.end(), watch->last_files.begin(), watch->last_files.end(), std::inserter(added, added.end()));
 
           std::set<std::string> removed;
-          // In the end, the set 'removed' will contain the m_last_files-current.
-          std::set_difference(m_last_files.begin(), m_last_files.end(), current.begin(), current.end(), std::inserter(removed, removed.end()));
+          // In the end, the set 'removed' will contain the last_files-current.
+          std::set_difference(watch->last_files.begin(), watch->last_files.end(), current.begin(), current.end(), std::inserter(removed, removed.end()));
           for (const std::string &f : removed)
           {
             Logging::INFO("File '" + f + "' removed from directory", m_name);
           }
 
-          m_last_files = current;
+          watch->last_files = current;
+
+          // add_directory() may reallocate m_watches, so 'watch' is not used below
+          DirectoryConfig directory = watch->directory;
+          for (const std::string &f : added)
+          {
+            if (std::filesystem::is_directory(f))
+            {
+              if (directory.recursive)
+              {
+                // Files may have been added before the watch existed
+                add_directory(DirectoryConfig{f, true, directory.profile}, false);
+                register_watches();
+              }
+            }
+            else if (should_add_file(f, false))
+            {
+              Logging::INFO("Adding file '" + f + "'", m_name);
+              m_file_paths.emplace_back(f, directory.profile);
+            }
+          }
         }
         if (m_ke->fflags & NOTE_EXTEND)
         {
@@ -186,9 +249,9 @@ PollResult DirectoryPoller::poll()
     }
     else
     {
-      std::string p = m_file_paths.back();
+      PollResult p = m_file_paths.back();
       m_file_paths.pop_back();
-      return PollResult(p);
+      return p;
     }
   }
 }
@@ -210,6 +273,13 @@ void DirectoryPoller::clean()
 
 DirectoryPoller::~DirectoryPoller()
 {
+  for (const Watch &watch : m_watches)
+  {
+    if (watch.fd != -1 && fcntl(watch.fd, F_GETFD) != -1)
+    {
+      close(watch.fd);
+    }
+  }
   if (fcntl(m_kq, F_GETFD) != -1)
   {
     close(m_kq);
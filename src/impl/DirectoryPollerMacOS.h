@@ -9,13 +9,14 @@
 #include <set>
 #include "AbstractPoller.h"
 #include "impl/PollResult.h"
+#include "config/DirectoryConfig.h"
 
 class DirectoryPollerBuilder;
 
 class DirectoryPoller : public AbstractPoller
 {
 public:
-  DirectoryPoller(std::string name, std::string dir_to_watch, std::shared_ptr<SignalChannel> sig_channel);
+  DirectoryPoller(std::string name, std::vector<DirectoryConfig> directories, std::shared_ptr<SignalChannel> sig_channel);
   ~DirectoryPoller() override;
   AbstractPoller *clone() const override;
 
@@ -23,17 +24,25 @@ public:
   static DirectoryPollerBuilder builder(std::string name);
 
 private:
+  // A watched directory, every subdirectory of a recursive directory is watched separately
+  struct Watch
+  {
+    DirectoryConfig directory;
+    int fd = -1;
+    std::set<std::string> last_files;
+  };
+
   PollResult poll() override;
   void clean() override;
-  std::set<std::string> list_files();
+  std::set<std::string> list_files(const std::string &path);
   bool should_add_file(const std::string &f, bool starting_up);
-  std::string m_dir_to_watch;
-  std::vector<std::string> m_file_paths;
+  void add_directory(const DirectoryConfig &directory, bool starting_up);
+  bool register_watches();
+  std::vector<PollResult> m_file_paths;
   bool init_dir_watch();
   int m_kq = -1;
-  int m_fd = -1;
   struct kevent *m_ke;
-  std::set<std::string> m_last_files;
+  std::vector<Watch> m_watches;
 };
 
 #endif
@@ -0,0 +1,149 @@
+#include "FileCheckpoint.h"
+#include "logging/Logging.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sys/stat.h>
+
+static const std::string name = "FileCheckpoint";
+
+void CheckpointSegment::add(size_t messages)
+{
+    m_refs.fetch_add(messages, std::memory_order_relaxed);
+}
+
+void CheckpointSegment::ack(bool delivered)
+{
+    if (!delivered)
+    {
+        m_failed.store(true, std::memory_order_relaxed);
+    }
+    unref();
+}
+
+void CheckpointSegment::unref()
+{
+    // Whoever drops the last reference (FileCheckpoint or a late delivery report) frees the segment
+    if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        delete this;
+    }
+}
+
+FileCheckpoint::FileCheckpoint(std::string path, const std::string &input_path) : m_path(path)
+{
+    // Inodes of deleted files are reused, the modification time tells a new file apart
+    struct stat st;
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(input_path, ec);
+    if (stat(input_path.c_str(), &st) == 0 && !ec)
+    {
+        m_identity = std::to_string(st.st_ino) + " " + std::to_string(st.st_size) + " " + std::to_string(mtime.time_since_epoch().count());
+    }
+
+    std::ifstream is(m_path);
+    size_t resume_row = 0;
+    std::string identity;
+    if (is.is_open() && (is >> resume_row) && std::getline(is >> std::ws, identity))
+    {
+        if (!m_identity.empty() && identity == m_identity)
+        {
+            m_resume_row = resume_row;
+            Logging::INFO("Resuming '" + m_path + "' after row " + std::to_string(m_resume_row), name);
+        }
+        else
+        {
+            Logging::WARN("Ignoring '" + m_path + "', it belongs to another file (" + identity + ", expected " + m_identity + ")", name);
+        }
+    }
+    else if (is.is_open())
+    {
+        Logging::WARN("Ignoring '" + m_path + "' without a file identity", name);
+    }
+    m_acked_row = m_resume_row;
+}
+
+FileCheckpoint::~FileCheckpoint()
+{
+    for (CheckpointSegment *segment : m_segments)
+    {
+        segment->unref();
+    }
+}
+
+size_t FileCheckpoint::resume_row() const
+{
+    return m_resume_row;
+}
+
+CheckpointSegment *FileCheckpoint::current()
+{
+    if (m_segments.empty() || m_segments.back()->m_closed)
+    {
+        m_segments.push_back(new CheckpointSegment());
+    }
+    return m_segments.back();
+}
+
+void FileCheckpoint::close(size_t end_row)
+{
+    CheckpointSegment *segment = current();
+    segment->m_end_row = end_row;
+    segment->m_closed = true;
+    advance();
+}
+
+void FileCheckpoint::advance()
+{
+    size_t acked_row = m_acked_row;
+    while (!m_segments.empty())
+    {
+        CheckpointSegment *segment = m_segments.front();
+        if (!segment->m_closed || segment->m_refs.load(std::memory_order_acquire) != 1 || segment->m_failed.load(std::memory_order_relaxed))
+        {
+            // Still open, outstanding messages, or failed ones which must be replayed after a restart
+            break;
+        }
+
+        acked_row = segment->m_end_row;
+        m_segments.pop_front();
+        segment->unref();
+    }
+
+    if (acked_row != m_acked_row)
+    {
+        m_acked_row = acked_row;
+        save();
+    }
+}
+
+bool FileCheckpoint::complete() const
+{
+    return m_segments.empty();
+}
+
+bool FileCheckpoint::save()
+{
+    std::string tmp_path = m_path + "_tmp";
+    {
+        std::ofstream os(tmp_path, std::ios::trunc);
+        os << m_acked_row << ' ' << m_identity << '\n';
+        if (!os.good())
+        {
+            Logging::ERROR("Failed to write '" + tmp_path + "'", name);
+            return false;
+        }
+    }
+
+    if (std::rename(tmp_path.c_str(), m_path.c_str()) != 0)
+    {
+        Logging::ERROR("Failed to replace '" + m_path + "'", name);
+        return false;
+    }
+    return true;
+}
+
+void FileCheckpoint::remove()
+{
+    std::remove(m_path.c_str());
+}
@@ -0,0 +1,101 @@
+/**
+ * Per-file checkpoint of the rows whose messages have all been acknowledged by Kafka, kept
+ * in a small sidecar file next to the input file (<file>_checkpoint).
+ *
+ * The rows of a file are split into segments of a few thousand rows. Every message carries
+ * its segment, which the sink acks once the message is durable (for Kafka: from the delivery
+ * report callback, where the segment is the message's opaque). The checkpoint advances over
+ * the contiguous prefix of segments whose messages were all delivered successfully, so a
+ * restart resumes after the last fully acknowledged segment and replays at most the
+ * segments after it.
+ *
+ * The sidecar also records the identity (inode, size and modification time) of the input file. A sidecar left
+ * behind for another file of the same name is ignored instead of skipping its rows.
+ **/
+#ifndef FILE_CHECKPOINT_H
+#define FILE_CHECKPOINT_H
+
+#include <atomic>
+#include <deque>
+#include <string>
+
+class CheckpointSegment
+{
+private:
+    size_t m_end_row = 0;
+    bool m_closed = false;
+
+    // One reference per unacknowledged message plus one held by the FileCheckpoint
+    std::atomic<size_t> m_refs = 1;
+    std::atomic<bool> m_failed = false;
+
+    friend class FileCheckpoint;
+    CheckpointSegment() = default;
+    void unref();
+
+public:
+    CheckpointSegment(const CheckpointSegment &) = delete;
+    void operator=(const CheckpointSegment &) = delete;
+
+    /**
+     * Account for messages about to be enqueued with this segment as opaque.
+     **/
+    void add(size_t messages);
+
+    /**
+     * Called once for every added message, from the delivery report callback or for messages
+     * that could not be enqueued. May delete the segment.
+     **/
+    void ack(bool delivered);
+};
+
+class FileCheckpoint
+{
+private:
+    const std::string m_path;
+    // Inode, size and modification time of the input file
+    std::string m_identity;
+    size_t m_resume_row = 0;
+    size_t m_acked_row = 0;
+    std::deque<CheckpointSegment *> m_segments;
+
+    bool save();
+
+public:
+    FileCheckpoint(std::string path, const std::string &input_path);
+    FileCheckpoint(const FileCheckpoint &) = delete;
+    void operator=(const FileCheckpoint &) = delete;
+    ~FileCheckpoint();
+
+    /**
+     * Number of data rows that were acknowledged in a previous run and can be skipped.
+     **/
+    size_t resume_row() const;
+
+    /**
+     * The segment the messages of the current rows belong to.
+     **/
+    CheckpointSegment *current();
+
+    /**
+     * Close the current segment at end_row (exclusive) and advance().
+     **/
+    void close(size_t end_row);
+
+    /**
+     * Drop the acknowledged segments from the front and persist the new row offset.
+     **/
+    void advance();
+
+    /**
+     * True if all segments were acknowledged successfully (call advance() first).
+     **/
+    bool complete() const;
+
+    /**
+     * Remove the sidecar file once the whole file was processed.
+     **/
+    void remove();
+};
+
+#endif
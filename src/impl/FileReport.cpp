@@ -0,0 +1,110 @@
+#include "FileReport.h"
+#include "logging/Logging.h"
+#include <cerrno>
+#include <cstring>
+
+static std::string name = "FileReportWriter";
+
+static void append_string(std::string &out, const std::string &value)
+{
+    out += '"';
+    for (char c : value)
+    {
+        switch (c)
+        {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char buffer[8];
+                snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                out += buffer;
+            }
+            else
+            {
+                out += c;
+            }
+        }
+    }
+    out += '"';
+}
+
+static void append_seconds(std::string &out, const char *key, FileReport::Clock::duration d)
+{
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), ",\"%s\":%.6f", key, std::chrono::duration<double>(d).count());
+    out += buffer;
+}
+
+std::string FileReport::to_json(time_t finished) const
+{
+    std::string out = "{\"file\":";
+    append_string(out, file);
+    out += ",\"status\":";
+    append_string(out, status);
+    out += ",\"finished\":" + std::to_string(finished);
+    out += ",\"rows_read\":" + std::to_string(rows_read);
+    out += ",\"rows_skipped\":" + std::to_string(rows_skipped);
+    out += ",\"rows_filtered\":" + std::to_string(rows_filtered);
+    out += ",\"rows_failed\":" + std::to_string(rows_failed);
+    out += ",\"bytes_in\":" + std::to_string(bytes_in);
+    out += ",\"bytes_out\":" + std::to_string(bytes_out);
+    out += ",\"messages\":" + std::to_string(messages);
+    append_seconds(out, "queue_wait_s", queue_wait);
+    append_seconds(out, "parse_s", parse);
+    append_seconds(out, "filter_s", filter);
+    append_seconds(out, "transform_s", transform);
+    append_seconds(out, "serialize_s", serialize);
+    append_seconds(out, "produce_s", produce);
+    append_seconds(out, "failed_s", failed);
+    append_seconds(out, "flush_s", flush);
+    append_seconds(out, "total_s", total);
+    out += "}\n";
+    return out;
+}
+
+FileReportWriter::FileReportWriter(std::string path) : m_path(path), m_file(fopen(path.c_str(), "a"))
+{
+    if (!m_file)
+    {
+        Logging::ERROR("Unable to open report file '" + m_path + "': " + strerror(errno), name);
+    }
+}
+
+FileReportWriter::~FileReportWriter()
+{
+    if (m_file)
+    {
+        fclose(m_file);
+    }
+}
+
+bool FileReportWriter::is_open() const
+{
+    return m_file != nullptr;
+}
+
+bool FileReportWriter::write(const FileReport &report)
+{
+    std::string line = report.to_json(time(NULL));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Flushed per report, so the file can be tailed
+    if (!m_file || fwrite(line.data(), 1, line.size(), m_file) != line.size() || fflush(m_file) != 0)
+    {
+        Logging::ERROR("Unable to write report file '" + m_path + "'", name);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,101 @@
+/**
+ * Per-file processing report, written as one JSON line per file to a report file, e.g.
+ *
+ * {"file":"/data/a.csv","status":"done","finished":1700000000,"rows_read":1000,"rows_skipped":0,
+ *  "rows_filtered":10,"rows_failed":0,"bytes_in":52311,"bytes_out":88000,"messages":990,
+ *  "queue_wait_s":0.002,"parse_s":0.011,"filter_s":0.001,"transform_s":0.003,"serialize_s":0.021,
+ *  "produce_s":0.004,"failed_s":0.000,"flush_s":0.150,"total_s":0.191}
+ *
+ * rows_read doesn't include the rows_skipped of a resumed file, which were acknowledged in a
+ * previous run. The stages add up to about total_s. failed_s is the time spent on rows that
+ * failed, flush_s the time spent waiting for the sink to make the messages durable (for Kafka:
+ * for the delivery reports).
+ **/
+#ifndef FILE_REPORT_H
+#define FILE_REPORT_H
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <mutex>
+#include <string>
+
+struct FileReport
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::string file;
+    std::string status;
+    size_t rows_read = 0;
+    size_t rows_skipped = 0;
+    size_t rows_filtered = 0;
+    size_t rows_failed = 0;
+    size_t bytes_in = 0;
+    size_t bytes_out = 0;
+    size_t messages = 0;
+
+    Clock::duration queue_wait{};
+    Clock::duration parse{};
+    Clock::duration filter{};
+    Clock::duration transform{};
+    Clock::duration serialize{};
+    Clock::duration produce{};
+    Clock::duration failed{};
+    Clock::duration flush{};
+    Clock::duration total{};
+
+    std::string to_json(time_t finished) const;
+};
+
+/**
+ * Attributes the time between two laps to a stage. Does nothing (not even read the clock)
+ * when disabled.
+ **/
+class StageTimer
+{
+private:
+    bool m_enabled = false;
+    FileReport::Clock::time_point m_last;
+
+public:
+    void start(bool enabled)
+    {
+        m_enabled = enabled;
+        if (m_enabled)
+        {
+            m_last = FileReport::Clock::now();
+        }
+    }
+
+    void lap(FileReport::Clock::duration &stage)
+    {
+        if (m_enabled)
+        {
+            FileReport::Clock::time_point now = FileReport::Clock::now();
+            stage += now - m_last;
+            m_last = now;
+        }
+    }
+};
+
+/**
+ * Appends reports to the report file. Shared by all processors.
+ **/
+class FileReportWriter
+{
+private:
+    const std::string m_path;
+    FILE *m_file;
+    std::mutex m_mutex;
+
+public:
+    FileReportWriter(std::string path);
+    FileReportWriter(const FileReportWriter &) = delete;
+    void operator=(const FileReportWriter &) = delete;
+    ~FileReportWriter();
+
+    bool is_open() const;
+    bool write(const FileReport &report);
+};
+
+#endif
@@ -0,0 +1,79 @@
+#include "InFlightBudget.h"
+#include <algorithm>
+#include <chrono>
+
+InFlightBudget::InFlightBudget(size_t max_bytes, size_t max_messages, std::shared_ptr<SignalChannel> sig_channel) : m_max_bytes(max_bytes), m_max_messages(max_messages), m_sig_channel(sig_channel)
+{
+}
+
+void InFlightBudget::acquire(size_t bytes, size_t messages)
+{
+    std::unique_lock lock(m_mutex);
+    auto fits = [this, bytes, messages]()
+    {
+        bool idle = m_bytes == 0 && m_messages == 0;
+        return idle || (m_bytes + bytes <= m_max_bytes && m_messages + messages <= m_max_messages);
+    };
+
+    if (!fits())
+    {
+        m_blocked_count.fetch_add(1, std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        ++m_waiters;
+
+        // Wake up periodically to notice a shutdown request
+        while (!m_cv.wait_for(lock, std::chrono::milliseconds(100), fits))
+        {
+            if (m_sig_channel->m_shutdown_requested.load())
+            {
+                break;
+            }
+        }
+
+        --m_waiters;
+        auto blocked = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        m_blocked_us.fetch_add(blocked.count(), std::memory_order_relaxed);
+    }
+
+    m_bytes += bytes;
+    m_messages += messages;
+}
+
+void InFlightBudget::release(size_t bytes, size_t messages)
+{
+    bool notify;
+    {
+        std::unique_lock lock(m_mutex);
+        m_bytes -= std::min(bytes, m_bytes);
+        m_messages -= std::min(messages, m_messages);
+        notify = m_waiters > 0;
+    }
+
+    // Called once per delivery report, only pay for the notification if someone is waiting
+    if (notify)
+    {
+        m_cv.notify_all();
+    }
+}
+
+size_t InFlightBudget::in_flight_bytes()
+{
+    std::unique_lock lock(m_mutex);
+    return m_bytes;
+}
+
+size_t InFlightBudget::in_flight_messages()
+{
+    std::unique_lock lock(m_mutex);
+    return m_messages;
+}
+
+size_t InFlightBudget::blocked_count() const
+{
+    return m_blocked_count.load(std::memory_order_relaxed);
+}
+
+uint64_t InFlightBudget::blocked_ms() const
+{
+    return m_blocked_us.load(std::memory_order_relaxed) / 1000;
+}
@@ -0,0 +1,56 @@
+/**
+ * Global budget of messages (and their bytes) that have been handed to librdkafka but whose
+ * delivery report has not been served yet. Shared by all processor threads and producers.
+ *
+ * Processors acquire() before enqueueing a batch and block while the budget is exhausted.
+ * The delivery report callback release()s every message, which wakes the blocked processors.
+ * This keeps the producers' queues below their limits, so that QUEUE_FULL is not hit under
+ * broker slowness and throughput degrades smoothly instead of in poll-and-retry steps.
+ **/
+#ifndef IN_FLIGHT_BUDGET_H
+#define IN_FLIGHT_BUDGET_H
+
+#include "SignalChannel.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+class InFlightBudget
+{
+private:
+    const size_t m_max_bytes;
+    const size_t m_max_messages;
+    std::shared_ptr<SignalChannel> m_sig_channel;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    size_t m_bytes = 0;
+    size_t m_messages = 0;
+    size_t m_waiters = 0;
+
+    std::atomic<size_t> m_blocked_count = 0;
+    std::atomic<uint64_t> m_blocked_us = 0;
+
+public:
+    InFlightBudget(size_t max_bytes, size_t max_messages, std::shared_ptr<SignalChannel> sig_channel);
+    InFlightBudget(const InFlightBudget &) = delete;
+    void operator=(const InFlightBudget &) = delete;
+
+    /**
+     * Block until the messages fit into the budget, then account for them. A request larger
+     * than the whole budget is let through once nothing else is in flight. Does not block
+     * once shutdown has been requested, since delivery reports may no longer be served.
+     **/
+    void acquire(size_t bytes, size_t messages);
+    void release(size_t bytes, size_t messages);
+
+    size_t in_flight_bytes();
+    size_t in_flight_messages();
+
+    // Number of times and total time processors were blocked in acquire()
+    size_t blocked_count() const;
+    uint64_t blocked_ms() const;
+};
+
+#endif
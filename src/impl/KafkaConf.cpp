@@ -0,0 +1,79 @@
+#include "KafkaConf.h"
+#include "logging/Logging.h"
+#include <stdexcept>
+
+static std::string name = "KafkaConf";
+
+std::map<std::string, std::string> KafkaConf::profile(const std::string &profile_name)
+{
+    if (!profile_name.compare("high_throughput"))
+    {
+        return {
+            {"compression.type", "lz4"},                // Cheap on CPU, good ratio on CSV-ish payloads
+            {"linger.ms", "50"},                        // Give batches time to fill up
+            {"batch.num.messages", "100000"},           // Let batch.size be the limiting factor
+            {"batch.size", "1000000"},                  // ~1MB per batch and partition
+            {"queue.buffering.max.kbytes", "1048576"},  // 1GB local queue before ERR__QUEUE_FULL
+            {"queue.buffering.max.messages", "1000000"},
+            {"socket.send.buffer.bytes", "1048576"}};
+    }
+    else if (!profile_name.compare("low_latency"))
+    {
+        return {
+            {"linger.ms", "0"},
+            {"acks", "1"}};
+    }
+
+    throw std::invalid_argument("Unknown kafka profile '" + profile_name + "'. Valid profiles are: high_throughput, low_latency");
+}
+
+RdKafka::Conf *KafkaConf::create(const std::map<std::string, std::string> &config, std::string &errstr)
+{
+    std::map<std::string, std::string> properties;
+
+    auto profile_it = config.find("profile");
+    if (profile_it != config.end())
+    {
+        try
+        {
+            properties = profile(profile_it->second);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            errstr = e.what();
+            return nullptr;
+        }
+    }
+
+    // Explicitly configured properties win over the profile
+    for (const auto &[key, value] : config)
+    {
+        if (FLYCATCHER_KEYS.find(key) == FLYCATCHER_KEYS.end())
+        {
+            properties[key] = value;
+        }
+    }
+
+    RdKafka::Conf *conf = RdKafka::Conf::create(RdKafka::Conf::CONF_GLOBAL);
+    std::string err;
+    errstr.clear();
+    for (const auto &[key, value] : properties)
+    {
+        if (conf->set(key, value, err) != RdKafka::Conf::CONF_OK)
+        {
+            errstr += (errstr.empty() ? "" : "\n") + std::string("kafka.") + key + ": " + err;
+            continue;
+        }
+
+        bool secret = key.find("password") != std::string::npos || key.find("secret") != std::string::npos;
+        Logging::INFO("Set " + key + "=" + (secret ? "***" : value), name);
+    }
+
+    if (!errstr.empty())
+    {
+        delete conf;
+        return nullptr;
+    }
+
+    return conf;
+}
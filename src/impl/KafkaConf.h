@@ -0,0 +1,34 @@
+/**
+ * Create the librdkafka configuration from the 'kafka' section of the configuration file.
+ *
+ * Every key except the ones used by flycatcher itself (see FLYCATCHER_KEYS) is passed
+ * through to librdkafka as is, so any producer property (compression.type, linger.ms,
+ * batch.num.messages, acks, ...) can be tuned without rebuilding. An optional 'profile'
+ * key selects a set of recommended defaults which explicitly configured keys override.
+ **/
+#ifndef KAFKA_CONF_H
+#define KAFKA_CONF_H
+
+#include <librdkafka/rdkafkacpp.h>
+#include <map>
+#include <set>
+#include <string>
+
+namespace KafkaConf
+{
+    const std::set<std::string> FLYCATCHER_KEYS = {"schema.registry.url", "schema.registry.attempts", "schema.registry.backoff.ms", "schema.registry.cache", "profile"};
+
+    /**
+     * Recommended librdkafka properties for the given profile. Throws std::invalid_argument
+     * on unknown profiles.
+     **/
+    std::map<std::string, std::string> profile(const std::string &name);
+
+    /**
+     * Create a global configuration from the given 'kafka' section. All invalid or unknown
+     * properties are reported at once in errstr, in which case nullptr is returned.
+     **/
+    RdKafka::Conf *create(const std::map<std::string, std::string> &config, std::string &errstr);
+};
+
+#endif
@@ -1,16 +1,57 @@
 #include "KafkaDeliveryReportCb.h"
+#include "FileCheckpoint.h"
+#include "sinks/KafkaSink.h"
 #include "logging/Logging.h"
+#include "metrics/Metrics.h"
 
 static std::string name = "KafkaDeliveryReportCb";
 
+static Metrics::Counter &delivered_total = Metrics::Registry::instance().counter("flycatcher_kafka_messages_total", "Delivery reports", Metrics::label("result", "delivered"));
+static Metrics::Counter &failed_total = Metrics::Registry::instance().counter("flycatcher_kafka_messages_total", "Delivery reports", Metrics::label("result", "failed"));
+static Metrics::Histogram &delivery_latency = Metrics::Registry::instance().histogram("flycatcher_kafka_delivery_latency_seconds", "Time from produce() to the delivery report", Metrics::exponential_buckets(0.001, 2, 14));
+
+KafkaDeliveryReportCb::KafkaDeliveryReportCb(InFlightBudget *in_flight_budget) : m_in_flight_budget(in_flight_budget)
+{
+}
+
 void KafkaDeliveryReportCb::dr_cb(RdKafka::Message &message)
 {
+    if (m_in_flight_budget)
+    {
+        m_in_flight_budget->release(message.len() + message.key_len(), 1);
+    }
+
+    // Messages of files with checkpoints carry their segment
+    KafkaDelivery *delivery = static_cast<KafkaDelivery *>(message.msg_opaque());
+    if (delivery)
+    {
+        if (delivery->segment)
+        {
+            delivery->segment->ack(message.err() == RdKafka::ERR_NO_ERROR);
+        }
+        if (message.err() != RdKafka::ERR_NO_ERROR)
+        {
+            delivery->counts->failed.fetch_add(1);
+        }
+        delivery->counts->in_flight.fetch_sub(1);
+        delete delivery;
+    }
+
+    // Microseconds, -1 if unknown
+    int64_t latency = message.latency();
+    if (latency >= 0)
+    {
+        delivery_latency.observe(latency / 1e6);
+    }
+
     if (message.err())
     {
+        failed_total.inc();
         Logging::ERROR("Message delivery failed: " + message.errstr(), name);
     }
     else
     {
-        Logging::INFO("Message delivered to topic " + message.topic_name() + " [" + std::to_string(message.partition()) + "] at offset " + std::to_string(message.offset()), name);
+        delivered_total.inc();
+        LOG_INFO("Message delivered to topic " + message.topic_name() + " [" + std::to_string(message.partition()) + "] at offset " + std::to_string(message.offset()), name);
     }
 }
\ No newline at end of file
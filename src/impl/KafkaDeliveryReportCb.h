@@ -7,11 +7,16 @@
 #ifndef KAFKA_DELIVERY_REPORT_CB_H
 #define KAFKA_DELIVERY_REPORT_CB_H
 
+#include "InFlightBudget.h"
 #include <librdkafka/rdkafkacpp.h>
 
 class KafkaDeliveryReportCb : public RdKafka::DeliveryReportCb
 {
+private:
+    InFlightBudget *m_in_flight_budget;
+
 public:
+    KafkaDeliveryReportCb(InFlightBudget *in_flight_budget = nullptr);
     void dr_cb(RdKafka::Message &message);
 };
 
@@ -0,0 +1,122 @@
+#include "KafkaEventCb.h"
+#include "logging/Logging.h"
+#include "metrics/Metrics.h"
+#include <algorithm>
+#include <sstream>
+
+static std::string name = "KafkaEventCb";
+
+/* Percentiles of the rolling windows (e.g. rtt) exposed as quantiles */
+static const std::pair<const char *, const char *> PERCENTILES[] = {{"p50", "0.5"}, {"p95", "0.95"}, {"p99", "0.99"}};
+
+KafkaEventCb::KafkaEventCb(size_t batch_size) : m_batch_size(static_cast<double>(batch_size))
+{
+}
+
+void KafkaEventCb::event_cb(RdKafka::Event &event)
+{
+    switch (event.type())
+    {
+    case RdKafka::Event::EVENT_STATS:
+        stats(event.str());
+        break;
+    case RdKafka::Event::EVENT_ERROR:
+        Logging::ERROR((event.fatal() ? "Fatal error: " : "") + RdKafka::err2str(event.err()) + ": " + event.str(), name);
+        break;
+    case RdKafka::Event::EVENT_THROTTLE:
+        Logging::WARN("Throttled by broker: " + event.str(), name);
+        break;
+    case RdKafka::Event::EVENT_LOG:
+        if (event.severity() <= RdKafka::Event::EVENT_SEVERITY_ERROR)
+        {
+            Logging::ERROR(event.fac() + ": " + event.str(), name);
+        }
+        else if (event.severity() == RdKafka::Event::EVENT_SEVERITY_WARNING)
+        {
+            LOG_WARN(event.fac() + ": " + event.str(), name);
+        }
+        else if (event.severity() == RdKafka::Event::EVENT_SEVERITY_DEBUG)
+        {
+            LOG_DEBUG(event.fac() + ": " + event.str(), name);
+        }
+        else
+        {
+            LOG_INFO(event.fac() + ": " + event.str(), name);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * Sets the gauges of a rolling window ({"avg": .., "p50": .., "p99": .., ...}) and returns its p99.
+ **/
+double KafkaEventCb::window(const YAML::Node &node, const std::string &metric, const std::string &help, const std::string &labels, double scale)
+{
+    Metrics::Registry &metrics = Metrics::Registry::instance();
+    for (const auto &[percentile, quantile] : PERCENTILES)
+    {
+        metrics.gauge(metric, help, labels + "," + Metrics::label("quantile", quantile)).set(node[percentile].as<double>() * scale);
+    }
+    metrics.gauge(metric + "_avg", help + " (average)", labels).set(node["avg"].as<double>() * scale);
+    return node["p99"].as<double>() * scale;
+}
+
+void KafkaEventCb::stats(const std::string &json)
+{
+    try
+    {
+        // JSON is valid YAML, which saves us another parser
+        YAML::Node root = YAML::Load(json);
+        Metrics::Registry &metrics = Metrics::Registry::instance();
+        std::string client = root["name"].as<std::string>();
+        std::string client_label = Metrics::label("client", client);
+
+        double msg_cnt = root["msg_cnt"].as<double>();
+        metrics.gauge("flycatcher_kafka_queue_messages", "Messages waiting in the producer", client_label).set(msg_cnt);
+        metrics.gauge("flycatcher_kafka_queue_bytes", "Bytes of the messages waiting in the producer", client_label).set(root["msg_size"].as<double>());
+
+        // Worst of all brokers for the summary
+        double rtt_p99 = 0;
+        double int_latency_p99 = 0;
+        uint64_t retries = 0;
+        for (const auto &broker : root["brokers"])
+        {
+            const YAML::Node &b = broker.second;
+            if (b["nodeid"].as<int>() < 0)
+            {
+                // Bootstrap broker
+                continue;
+            }
+            std::string labels = client_label + "," + Metrics::label("broker", broker.first.as<std::string>());
+            rtt_p99 = std::max(rtt_p99, window(b["rtt"], "flycatcher_kafka_broker_rtt_seconds", "Broker round trip time", labels, 1e-6));
+            int_latency_p99 = std::max(int_latency_p99, window(b["int_latency"], "flycatcher_kafka_broker_int_latency_seconds", "Time messages wait in the producer queue", labels, 1e-6));
+            window(b["outbuf_latency"], "flycatcher_kafka_broker_outbuf_latency_seconds", "Time requests wait in the broker's output buffer", labels, 1e-6);
+            metrics.gauge("flycatcher_kafka_broker_retries", "Request retries", labels).set(b["txretries"].as<double>());
+            metrics.gauge("flycatcher_kafka_broker_request_timeouts", "Request timeouts", labels).set(b["req_timeouts"].as<double>());
+            retries += b["txretries"].as<uint64_t>();
+        }
+
+        std::stringstream topics;
+        for (const auto &topic : root["topics"])
+        {
+            const YAML::Node &t = topic.second;
+            std::string labels = client_label + "," + Metrics::label("topic", topic.first.as<std::string>());
+            window(t["batchsize"], "flycatcher_kafka_topic_batch_bytes", "Size of the produced batches", labels, 1);
+            window(t["batchcnt"], "flycatcher_kafka_topic_batch_messages", "Messages per produced batch", labels, 1);
+
+            double batch_fill = m_batch_size > 0 ? t["batchsize"]["avg"].as<double>() / m_batch_size : 0;
+            metrics.gauge("flycatcher_kafka_topic_batch_fill_ratio", "Average batch size relative to batch.size", labels).set(batch_fill);
+            topics << ", " << topic.first.as<std::string>() << ": " << t["batchcnt"]["avg"].as<int64_t>() << " messages/batch, " << static_cast<int>(batch_fill * 100) << "% batch fill";
+        }
+
+        std::stringstream ss;
+        ss << client << ": " << static_cast<int64_t>(msg_cnt) << " queued, int_latency p99 " << int_latency_p99 * 1000 << "ms, rtt p99 " << rtt_p99 * 1000 << "ms, " << retries << " retries" << topics.str();
+        LOG_INFO(ss.str(), name);
+    }
+    catch (const YAML::Exception &e)
+    {
+        Logging::WARN("Unable to parse statistics: " + std::string(e.what()), name);
+    }
+}
@@ -0,0 +1,31 @@
+/**
+ * Kafka event callback. Routes librdkafka's errors and log lines into our log and turns the
+ * statistics it emits every statistics.interval.ms (see STATISTICS.md of librdkafka) into
+ * metrics and a summary log line per producer:
+ *
+ *  - queue: messages and bytes waiting in the producer
+ *  - per broker: rtt, int_latency (time in the producer queue) and outbuf_latency
+ *    percentiles, retries and request timeouts
+ *  - per topic: batch size and message count percentiles, batch fill relative to batch.size
+ **/
+#ifndef KAFKA_EVENT_CB_H
+#define KAFKA_EVENT_CB_H
+
+#include <librdkafka/rdkafkacpp.h>
+#include <yaml-cpp/yaml.h>
+#include <string>
+
+class KafkaEventCb : public RdKafka::EventCb
+{
+private:
+    const double m_batch_size;
+
+    void stats(const std::string &json);
+    double window(const YAML::Node &node, const std::string &name, const std::string &help, const std::string &labels, double scale);
+
+public:
+    KafkaEventCb(size_t batch_size);
+    void event_cb(RdKafka::Event &event);
+};
+
+#endif
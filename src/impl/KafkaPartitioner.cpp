@@ -0,0 +1,88 @@
+#include "KafkaPartitioner.h"
+#include "logging/Logging.h"
+#include <memory>
+
+static std::string name = "KafkaPartitioner";
+
+int32_t KafkaPartitioner::murmur2(std::string_view data)
+{
+    const uint32_t seed = 0x9747b28c;
+    const uint32_t m = 0x5bd1e995;
+    const int r = 24;
+    const size_t length = data.size();
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data.data());
+
+    uint32_t h = seed ^ static_cast<uint32_t>(length);
+    size_t length4 = length / 4;
+
+    for (size_t i = 0; i < length4; ++i)
+    {
+        const size_t i4 = i * 4;
+        uint32_t k = bytes[i4 + 0] | (bytes[i4 + 1] << 8) | (bytes[i4 + 2] << 16) | (static_cast<uint32_t>(bytes[i4 + 3]) << 24);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h *= m;
+        h ^= k;
+    }
+
+    // Handle the last few bytes of the input array
+    const size_t tail = length & ~static_cast<size_t>(3);
+    switch (length % 4)
+    {
+    case 3:
+        h ^= bytes[tail + 2] << 16;
+        [[fallthrough]];
+    case 2:
+        h ^= bytes[tail + 1] << 8;
+        [[fallthrough]];
+    case 1:
+        h ^= bytes[tail];
+        h *= m;
+    }
+
+    h ^= h >> 13;
+    h *= m;
+    h ^= h >> 15;
+
+    return static_cast<int32_t>(h);
+}
+
+int32_t KafkaPartitioner::partition(std::string_view key, int32_t partition_cnt)
+{
+    return (murmur2(key) & 0x7fffffff) % partition_cnt;
+}
+
+std::map<std::string, int32_t> KafkaPartitioner::partition_counts(RdKafka::Producer *producer, const std::vector<std::string> &topics, int timeout_ms)
+{
+    std::map<std::string, int32_t> result;
+    for (const std::string &topic_name : topics)
+    {
+        std::string errstr;
+        std::unique_ptr<RdKafka::Topic> topic(RdKafka::Topic::create(producer, topic_name, nullptr, errstr));
+        if (!topic)
+        {
+            Logging::ERROR("Failed to create topic handle for '" + topic_name + "': " + errstr, name);
+            continue;
+        }
+
+        RdKafka::Metadata *metadata_ptr = nullptr;
+        RdKafka::ErrorCode err = producer->metadata(false, topic.get(), &metadata_ptr, timeout_ms);
+        std::unique_ptr<RdKafka::Metadata> metadata(metadata_ptr);
+        if (err != RdKafka::ERR_NO_ERROR)
+        {
+            Logging::ERROR("Failed to fetch metadata for topic '" + topic_name + "': " + RdKafka::err2str(err), name);
+            continue;
+        }
+
+        for (const RdKafka::TopicMetadata *topic_metadata : *metadata->topics())
+        {
+            if (!topic_metadata->topic().compare(topic_name) && topic_metadata->err() == RdKafka::ERR_NO_ERROR && !topic_metadata->partitions()->empty())
+            {
+                result[topic_name] = static_cast<int32_t>(topic_metadata->partitions()->size());
+                Logging::INFO("Topic '" + topic_name + "' has " + std::to_string(result[topic_name]) + " partitions", name);
+            }
+        }
+    }
+    return result;
+}
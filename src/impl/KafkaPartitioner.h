@@ -0,0 +1,37 @@
+/**
+ * Client-side partitioner that assigns keys to partitions exactly like the default
+ * partitioner of the Java client (and librdkafka's 'murmur2_random' for non-empty keys):
+ *
+ *   partition = (murmur2(key) & 0x7fffffff) % partition_cnt
+ *
+ * Knowing the partition up-front lets CsvProcessor group messages into per-partition
+ * batches that are enqueued with a single call into librdkafka.
+ **/
+#ifndef KAFKA_PARTITIONER_H
+#define KAFKA_PARTITIONER_H
+
+#include <librdkafka/rdkafkacpp.h>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class KafkaPartitioner
+{
+public:
+    /**
+     * Murmur2 hash as implemented by org.apache.kafka.common.utils.Utils.murmur2().
+     **/
+    static int32_t murmur2(std::string_view data);
+
+    static int32_t partition(std::string_view key, int32_t partition_cnt);
+
+    /**
+     * Fetch the number of partitions of each topic from the cluster. Topics whose metadata
+     * cannot be fetched are left out.
+     **/
+    static std::map<std::string, int32_t> partition_counts(RdKafka::Producer *producer, const std::vector<std::string> &topics, int timeout_ms);
+};
+
+#endif
@@ -4,7 +4,10 @@
 
 static std::string name = "KafkaPoller";
 
-KafkaPoller::KafkaPoller(RdKafka::Producer *kafka_producer, std::shared_ptr<SignalChannel> sig_channel) : m_kafka_producer(kafka_producer), m_sig_channel(sig_channel)
+static std::atomic<size_t> poller_count = 0;
+
+KafkaPoller::KafkaPoller(RdKafka::Producer *kafka_producer, std::shared_ptr<SignalChannel> sig_channel) : m_kafka_producer(kafka_producer), m_sig_channel(sig_channel),
+                                                                                                          m_outq_len(Metrics::Registry::instance().gauge("flycatcher_kafka_outq_len", "Messages and requests waiting in the producer's queues", Metrics::label("producer", std::to_string(poller_count++))))
 {
 }
 
@@ -31,8 +34,9 @@ void KafkaPoller::run()
                                      return should_shutdown; });
         }
 
-        m_kafka_producer->poll(0);
-        std::this_thread::sleep_for(std::chrono::milliseconds(10000));
+        // Serve delivery reports as they arrive; blocks for at most 100ms when idle
+        m_kafka_producer->poll(100);
+        m_outq_len.set(m_kafka_producer->outq_len());
     }
 
     Logging::INFO("Shutting down", name);
@@ -9,6 +9,7 @@
 #ifndef KAFKA_POLLER_H
 #define KAFKA_POLLER_H
 #include "SignalChannel.h"
+#include "metrics/Metrics.h"
 #include <thread>
 #include <memory>
 #include <librdkafka/rdkafkacpp.h>
@@ -25,6 +26,7 @@ private:
     RdKafka::Producer *m_kafka_producer;
     std::unique_ptr<std::thread> m_t;
     std::shared_ptr<SignalChannel> m_sig_channel;
+    Metrics::Gauge &m_outq_len;
     void run();
 };
 
@@ -1,6 +1,10 @@
 #include "PollResult.h"
 
-PollResult::PollResult(std::string result) : m_result(result) {}
+PollResult::PollResult(std::string result) : m_result(result), m_created(std::chrono::steady_clock::now()) {}
+
+PollResult::PollResult(std::string result, std::shared_ptr<const std::string> data, std::shared_ptr<std::atomic<bool>> failed) : m_result(result), m_created(std::chrono::steady_clock::now()), m_data(data), m_failed(failed) {}
+
+PollResult::PollResult(std::string result, std::string profile) : m_result(result), m_created(std::chrono::steady_clock::now()), m_profile(profile) {}
 
 std::string PollResult::get() const
 {
@@ -10,4 +14,24 @@ std::string PollResult::get() const
 bool PollResult::empty() const
 {
     return this->get().empty();
+}
+
+const std::shared_ptr<const std::string> &PollResult::data() const
+{
+    return m_data;
+}
+
+const std::shared_ptr<std::atomic<bool>> &PollResult::failed() const
+{
+    return m_failed;
+}
+
+const std::string &PollResult::profile() const
+{
+    return m_profile;
+}
+
+std::chrono::steady_clock::time_point PollResult::created() const
+{
+    return m_created;
 }
\ No newline at end of file
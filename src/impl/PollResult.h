@@ -1,18 +1,40 @@
 #ifndef POLL_RESULT_H
 #define POLL_RESULT_H
 
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <string>
 
 class PollResult
 {
 public:
    PollResult(std::string result_);
+
+   // In-memory CSV (header and rows) received from result_, e.g. a socket connection. The
+   // processor sets failed_ when the rows could not be published.
+   PollResult(std::string result_, std::shared_ptr<const std::string> data_, std::shared_ptr<std::atomic<bool>> failed_);
+
+   // File of a directory whose files are processed with the given profile
+   PollResult(std::string result_, std::string profile_);
    std::string get() const;
    bool empty() const;
+   const std::shared_ptr<const std::string> &data() const;
+   const std::shared_ptr<std::atomic<bool>> &failed() const;
+
+   // Empty for the default profile
+   const std::string &profile() const;
+
+   // When the poller found the file
+   std::chrono::steady_clock::time_point created() const;
    ~PollResult() {}
 
 private:
    std::string m_result;
+   std::chrono::steady_clock::time_point m_created;
+   std::shared_ptr<const std::string> m_data;
+   std::shared_ptr<std::atomic<bool>> m_failed;
+   std::string m_profile;
 };
 
 #endif
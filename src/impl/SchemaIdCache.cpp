@@ -0,0 +1,272 @@
+#include "SchemaIdCache.h"
+#include "logging/Logging.h"
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+static const std::string name = "SchemaIdCache";
+
+SchemaIdCache::SchemaIdCache(std::string path) : m_path(path)
+{
+    load();
+}
+
+SchemaIdCache::~SchemaIdCache()
+{
+    join();
+}
+
+void SchemaIdCache::load()
+{
+    std::ifstream is(m_path);
+    if (!is.is_open())
+    {
+        Logging::INFO("No schema id cache at '" + m_path + "' yet", name);
+        return;
+    }
+
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(is, line))
+    {
+        ++line_number;
+        std::istringstream ls(line);
+        std::string subject;
+        uint64_t fingerprint;
+        int32_t id;
+        if (!(ls >> subject >> std::hex >> fingerprint >> std::dec >> id))
+        {
+            Logging::ERROR("Ignoring malformed line " + std::to_string(line_number) + " in '" + m_path + "'", name);
+            continue;
+        }
+        m_ids[std::make_pair(subject, fingerprint)] = id;
+    }
+
+    Logging::INFO("Loaded " + std::to_string(m_ids.size()) + " schema id(s) from '" + m_path + "'", name);
+}
+
+int32_t SchemaIdCache::lookup(const std::string &subject, uint64_t fingerprint)
+{
+    std::unique_lock lock(m_mutex);
+    auto it = m_ids.find(std::make_pair(subject, fingerprint));
+    return it != m_ids.end() ? it->second : -1;
+}
+
+void SchemaIdCache::store(const std::string &subject, uint64_t fingerprint, int32_t id)
+{
+    std::unique_lock lock(m_mutex);
+    m_ids[std::make_pair(subject, fingerprint)] = id;
+}
+
+bool SchemaIdCache::save()
+{
+    std::unique_lock lock(m_mutex);
+    std::string tmp_path = m_path + ".tmp";
+    {
+        std::ofstream os(tmp_path, std::ios::trunc);
+        for (const auto &[key, id] : m_ids)
+        {
+            os << key.first << ' ' << std::hex << std::setw(16) << std::setfill('0') << key.second << std::dec << ' ' << id << '\n';
+        }
+        if (!os.good())
+        {
+            Logging::ERROR("Failed to write '" + tmp_path + "'", name);
+            return false;
+        }
+    }
+
+    if (std::rename(tmp_path.c_str(), m_path.c_str()) != 0)
+    {
+        Logging::ERROR("Failed to replace '" + m_path + "'", name);
+        return false;
+    }
+    return true;
+}
+
+void SchemaIdCache::refresh_async(std::vector<Entry> entries, Resolver resolver)
+{
+    // Runs after a previous refresh (e.g. of another profile's schemas), without blocking the caller
+    std::thread previous = std::move(m_refresh);
+    m_refresh = std::thread([this, previous = std::move(previous), entries = std::move(entries), resolver]() mutable
+                            {
+        if (previous.joinable())
+        {
+            previous.join();
+        }
+
+        bool changed = false;
+        for (const Entry &entry : entries)
+        {
+            int32_t id = resolver(entry);
+            if (id == -1)
+            {
+                // Keep the cached id, the registry may just be unavailable
+                continue;
+            }
+
+            int32_t cached = lookup(entry.subject, entry.fingerprint);
+            if (id != cached)
+            {
+                // Messages serialized until now carry the stale id
+                Logging::WARN("Cached schema id " + std::to_string(cached) + " for '" + entry.subject + "' is stale, registry returned " + std::to_string(id) + ". Using the new id from now on", name);
+                store(entry.subject, entry.fingerprint, id);
+                if (entry.id)
+                {
+                    entry.id->store(id);
+                }
+                changed = true;
+            }
+        }
+
+        if (changed)
+        {
+            save();
+        }
+        LOG_DEBUG("Refreshed " + std::to_string(entries.size()) + " cached schema id(s)", name); });
+}
+
+void SchemaIdCache::join()
+{
+    if (m_refresh.joinable())
+    {
+        m_refresh.join();
+    }
+}
+
+static void write_canonical(const avro::NodePtr &node, std::set<std::string> &defined, std::ostream &os)
+{
+    // https://avro.apache.org/docs/current/specification/#parsing-canonical-form-for-schemas
+    switch (node->type())
+    {
+    case avro::AVRO_STRING:
+        os << "\"string\"";
+        return;
+    case avro::AVRO_BYTES:
+        os << "\"bytes\"";
+        return;
+    case avro::AVRO_INT:
+        os << "\"int\"";
+        return;
+    case avro::AVRO_LONG:
+        os << "\"long\"";
+        return;
+    case avro::AVRO_FLOAT:
+        os << "\"float\"";
+        return;
+    case avro::AVRO_DOUBLE:
+        os << "\"double\"";
+        return;
+    case avro::AVRO_BOOL:
+        os << "\"boolean\"";
+        return;
+    case avro::AVRO_NULL:
+        os << "\"null\"";
+        return;
+    case avro::AVRO_SYMBOLIC:
+        os << '"' << node->name().fullname() << '"';
+        return;
+    case avro::AVRO_ARRAY:
+        os << "{\"type\":\"array\",\"items\":";
+        write_canonical(node->leafAt(0), defined, os);
+        os << '}';
+        return;
+    case avro::AVRO_MAP:
+        // Leaf 0 is the (implicit string) key type
+        os << "{\"type\":\"map\",\"values\":";
+        write_canonical(node->leafAt(1), defined, os);
+        os << '}';
+        return;
+    case avro::AVRO_UNION:
+        os << '[';
+        for (size_t i = 0; i < node->leaves(); ++i)
+        {
+            os << (i > 0 ? "," : "");
+            write_canonical(node->leafAt(i), defined, os);
+        }
+        os << ']';
+        return;
+    default:
+        break;
+    }
+
+    // Named types: a name that was already defined is written as just the name
+    const std::string fullname = node->name().fullname();
+    if (!defined.insert(fullname).second)
+    {
+        os << '"' << fullname << '"';
+        return;
+    }
+
+    os << "{\"name\":\"" << fullname << "\"";
+    switch (node->type())
+    {
+    case avro::AVRO_RECORD:
+        os << ",\"type\":\"record\",\"fields\":[";
+        for (size_t i = 0; i < node->leaves(); ++i)
+        {
+            os << (i > 0 ? "," : "") << "{\"name\":\"" << node->nameAt(i) << "\",\"type\":";
+            write_canonical(node->leafAt(i), defined, os);
+            os << '}';
+        }
+        os << ']';
+        break;
+    case avro::AVRO_ENUM:
+        os << ",\"type\":\"enum\",\"symbols\":[";
+        for (size_t i = 0; i < node->names(); ++i)
+        {
+            os << (i > 0 ? "," : "") << '"' << node->nameAt(i) << '"';
+        }
+        os << ']';
+        break;
+    case avro::AVRO_FIXED:
+        os << ",\"type\":\"fixed\",\"size\":" << node->fixedSize();
+        break;
+    default:
+        throw std::invalid_argument("Unsupported avro type " + std::to_string(node->type()));
+    }
+    os << '}';
+}
+
+std::string SchemaIdCache::canonical_form(const avro::ValidSchema &schema)
+{
+    std::set<std::string> defined;
+    std::ostringstream os;
+    write_canonical(schema.root(), defined, os);
+    return os.str();
+}
+
+uint64_t SchemaIdCache::fingerprint(const std::string &canonical_form)
+{
+    // CRC-64-AVRO, see https://avro.apache.org/docs/current/specification/#schema-fingerprints
+    static constexpr uint64_t EMPTY = 0xc15d213aa4d7a795ULL;
+    static const std::array<uint64_t, 256> table = []()
+    {
+        std::array<uint64_t, 256> t{};
+        for (uint64_t i = 0; i < 256; ++i)
+        {
+            uint64_t fp = i;
+            for (int j = 0; j < 8; ++j)
+            {
+                fp = (fp >> 1) ^ (EMPTY & -(fp & 1));
+            }
+            t[i] = fp;
+        }
+        return t;
+    }();
+
+    uint64_t fp = EMPTY;
+    for (unsigned char c : canonical_form)
+    {
+        fp = (fp >> 8) ^ table[(fp ^ c) & 0xff];
+    }
+    return fp;
+}
+
+uint64_t SchemaIdCache::fingerprint(const avro::ValidSchema &schema)
+{
+    return fingerprint(canonical_form(schema));
+}
@@ -0,0 +1,80 @@
+/**
+ * Local file caching the schema registry ids of the schemas flycatcher registers, keyed by
+ * subject and the fingerprint (CRC-64-AVRO of the Parsing Canonical Form) of the schema.
+ *
+ * A start with a warm cache resolves all schema ids without talking to the registry. The
+ * cached ids are then verified against the registry in the background by refresh_async(),
+ * which swaps a stale id in use for the registry's and updates the file.
+ *
+ * File format, one entry per line: <subject> <fingerprint as hex> <schema id>
+ **/
+#ifndef SCHEMA_ID_CACHE_H
+#define SCHEMA_ID_CACHE_H
+
+#include <avro/ValidSchema.hh>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class SchemaIdCache
+{
+public:
+    struct Entry
+    {
+        std::string subject;
+        uint64_t fingerprint;
+        std::string schema_def;
+        // The id in use (see SchemaConfig), swapped by refresh_async() if it is stale
+        std::shared_ptr<std::atomic<int32_t>> id;
+    };
+
+    // Resolves an entry against the registry. Returns -1 on failure.
+    using Resolver = std::function<int32_t(const Entry &)>;
+
+    SchemaIdCache(std::string path);
+    SchemaIdCache(const SchemaIdCache &) = delete;
+    void operator=(const SchemaIdCache &) = delete;
+    ~SchemaIdCache();
+
+    /**
+     * Returns the cached id or -1.
+     **/
+    int32_t lookup(const std::string &subject, uint64_t fingerprint);
+    void store(const std::string &subject, uint64_t fingerprint, int32_t id);
+
+    /**
+     * Write the cache file (atomically, through a temporary file and rename()).
+     **/
+    bool save();
+
+    /**
+     * Re-resolve the given entries on a background thread, update changed ids (in the cache and
+     * the entries' ids in use) and save.
+     **/
+    void refresh_async(std::vector<Entry> entries, Resolver resolver);
+
+    /**
+     * Wait for a running refresh to finish.
+     **/
+    void join();
+
+    static std::string canonical_form(const avro::ValidSchema &schema);
+    static uint64_t fingerprint(const avro::ValidSchema &schema);
+    static uint64_t fingerprint(const std::string &canonical_form);
+
+private:
+    const std::string m_path;
+    std::mutex m_mutex;
+    std::map<std::pair<std::string, uint64_t>, int32_t> m_ids;
+    std::thread m_refresh;
+
+    void load();
+};
+
+#endif
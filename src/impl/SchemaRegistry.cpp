@@ -1,5 +1,7 @@
 #include "SchemaRegistry.h"
 #include "logging/Logging.h"
+#include <algorithm>
+#include <chrono>
 #include <thread>
 #include <iostream>
 #include <signal.h>
@@ -112,11 +114,33 @@ int SchemaRegistry::register_value_schema(const std::string &schema_name, const
         std::stringstream ss;
         ss << "Failed to register new schema: '"
            << schema_name << "'"
-           << ", id: "
-           << schema->id()
+           << ", error: "
+           << errstr
            << ", definition: "
            << schema_def;
         Logging::ERROR(ss.str(), name);
     }
+    return -1;
+}
+
+int SchemaRegistry::resolve_value_schema(const std::string &schema_name, const std::string &schema_def, int max_attempts, int backoff_ms)
+{
+    for (int attempt = 1; attempt <= max_attempts; ++attempt)
+    {
+        // Registering an already known schema is idempotent and returns its existing id
+        int id = register_value_schema(schema_name, schema_def);
+        if (id != -1)
+        {
+            return id;
+        }
+
+        if (attempt < max_attempts)
+        {
+            Logging::INFO("Retrying schema '" + schema_name + "' in " + std::to_string(backoff_ms) + "ms (attempt " + std::to_string(attempt + 1) + "/" + std::to_string(max_attempts) + ")", name);
+            std::this_thread::sleep_for(std::chrono::milliseconds(backoff_ms));
+            backoff_ms = std::min(backoff_ms * 2, 30 * 1000);
+        }
+    }
+
     return -1;
 }
\ No newline at end of file
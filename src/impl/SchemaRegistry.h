@@ -23,6 +23,12 @@ public:
     static SchemaRegistry &instance();
     int fetch_value_schema_id(const std::string &schema_name);
     int register_value_schema(const std::string &schema_name, const std::string &schema_def);
+
+    /**
+     * Register the schema (or look up its id if the registry already knows it), retrying
+     * with exponential backoff starting at backoff_ms. Returns -1 if all attempts failed.
+     **/
+    int resolve_value_schema(const std::string &schema_name, const std::string &schema_def, int max_attempts, int backoff_ms);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,352 @@
+#ifdef __linux__
+#include "SocketPoller.h"
+#include "logging/Logging.h"
+#include "metrics/Metrics.h"
+#include "trace/Trace.h"
+#include <cerrno>
+#include <cstring>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+/* Longest line we buffer before giving up on a connection */
+static constexpr size_t MAX_LINE_SIZE = 16 * 1024 * 1024;
+
+static constexpr size_t READ_SIZE = 64 * 1024;
+
+/* Reads of a connection per readiness event. epoll is level-triggered, so the rest is read
+ * on the next poll(), after the back pressure was checked again. */
+static constexpr size_t MAX_READS_PER_EVENT = 16;
+
+static Metrics::Counter &connections_total = Metrics::Registry::instance().counter("flycatcher_socket_connections_total", "Accepted socket connections");
+static Metrics::Counter &batches_total = Metrics::Registry::instance().counter("flycatcher_socket_batches_total", "Row batches queued from socket connections");
+static Metrics::Gauge &open_connections = Metrics::Registry::instance().gauge("flycatcher_socket_connections", "Open socket connections");
+
+SocketPoller::SocketPoller(std::string name, std::string path, size_t batch_rows, int max_delay_ms, size_t max_queued_batches, std::shared_ptr<SignalChannel> sig_channel) : AbstractPoller(name, sig_channel), m_path(path), m_batch_rows(batch_rows > 0 ? batch_rows : 1), m_max_delay(max_delay_ms), m_max_queued_batches(max_queued_batches > 0 ? max_queued_batches : 1)
+{
+}
+
+bool SocketPoller::init_socket()
+{
+  sockaddr_un addr{};
+  if (m_path.size() >= sizeof(addr.sun_path))
+  {
+    Logging::ERROR("Socket path '" + m_path + "' is too long", m_name);
+    return false;
+  }
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, m_path.c_str(), sizeof(addr.sun_path) - 1);
+
+  m_listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (m_listen_fd < 0)
+  {
+    Logging::ERROR("Unable to create socket: " + std::string(strerror(errno)), m_name);
+    return false;
+  }
+
+  // Left behind by a previous run
+  unlink(m_path.c_str());
+  if (bind(m_listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || listen(m_listen_fd, 64) != 0)
+  {
+    Logging::ERROR("Unable to listen on '" + m_path + "': " + strerror(errno), m_name);
+    return false;
+  }
+
+  m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = m_listen_fd;
+  if (m_epoll_fd < 0 || epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_listen_fd, &event) != 0)
+  {
+    Logging::ERROR("Unable to set up epoll: " + std::string(strerror(errno)), m_name);
+    return false;
+  }
+
+  Logging::INFO("Listening on '" + m_path + "'", m_name);
+  return true;
+}
+
+PollResult SocketPoller::poll()
+{
+  if (m_epoll_fd < 0)
+  {
+    if (!init_socket())
+    {
+      kill(getpid(), SIGINT);
+      return PollResult("");
+    }
+  }
+
+  // Tell the clients about lost rows by closing their connection
+  std::vector<int> failed;
+  for (auto &[fd, c] : m_connections)
+  {
+    if (c.failed->load())
+    {
+      failed.push_back(fd);
+    }
+  }
+  for (int fd : failed)
+  {
+    Logging::ERROR("Rows of connection " + std::to_string(m_connections[fd].id) + " could not be published. Closing it", m_name);
+    close_connection(fd);
+  }
+
+  // Back pressure: don't read while the processors are behind
+  if (!backlogged())
+  {
+    TRACE_SPAN("SocketPoller::poll");
+
+    // Rows read before the processors fell behind
+    for (auto &[fd, c] : m_connections)
+    {
+      if (c.scanned < c.buffer.size())
+      {
+        scan(c);
+      }
+    }
+
+    epoll_event events[64];
+    int n = epoll_wait(m_epoll_fd, events, 64, static_cast<int>(m_max_delay.count()));
+    for (int i = 0; i < n; ++i)
+    {
+      int fd = events[i].data.fd;
+      if (fd == m_listen_fd)
+      {
+        accept_connections();
+        continue;
+      }
+
+      // The remaining events are reported again once the processors caught up
+      if (backlogged())
+      {
+        break;
+      }
+
+      auto it = m_connections.find(fd);
+      if (it != m_connections.end() && !read_connection(fd, it->second))
+      {
+        close_connection(fd);
+      }
+    }
+
+    // Rows that waited long enough for their batch to fill up
+    auto now = std::chrono::steady_clock::now();
+    for (auto &[fd, c] : m_connections)
+    {
+      if (c.rows > 0 && now - c.first_row >= m_max_delay)
+      {
+        cut(c);
+      }
+    }
+    open_connections.set(m_connections.size());
+  }
+
+  // Queue all batches right away, the worker loop only polls every few milliseconds
+  while (!m_batches.empty())
+  {
+    lane(m_batches.front().first)->enqueue(m_batches.front().second);
+    m_batches.pop_front();
+    batches_total.inc();
+  }
+  return PollResult("");
+}
+
+void SocketPoller::accept_connections()
+{
+  while (true)
+  {
+    int fd = accept4(m_listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0)
+    {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+      {
+        Logging::ERROR("accept failed: " + std::string(strerror(errno)), m_name);
+      }
+      return;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0)
+    {
+      Logging::ERROR("Unable to watch connection: " + std::string(strerror(errno)), m_name);
+      close(fd);
+      continue;
+    }
+
+    Connection &c = m_connections[fd];
+    c.id = ++m_connection_count;
+    connections_total.inc();
+    LOG_INFO("Accepted connection " + std::to_string(c.id), m_name);
+  }
+}
+
+bool SocketPoller::read_connection(int fd, Connection &c)
+{
+  char buffer[READ_SIZE];
+  for (size_t reads = 0; reads < MAX_READS_PER_EVENT; ++reads)
+  {
+    ssize_t n = read(fd, buffer, sizeof(buffer));
+    if (n > 0)
+    {
+      c.buffer.append(buffer, n);
+      scan(c);
+      if (c.buffer.size() - c.rows_end > MAX_LINE_SIZE)
+      {
+        Logging::ERROR("Line of connection " + std::to_string(c.id) + " exceeds " + std::to_string(MAX_LINE_SIZE) + " bytes. Closing it", m_name);
+        return false;
+      }
+      if (backlogged())
+      {
+        return true;
+      }
+      continue;
+    }
+
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+      return true;
+    }
+    if (n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (n < 0)
+    {
+      Logging::ERROR("Unable to read connection " + std::to_string(c.id) + ": " + strerror(errno), m_name);
+    }
+
+    // Closed by the client: the last row may lack its line end. Cut all rows, the buffer is
+    // at most one read beyond the back pressure limit.
+    if (c.buffer.size() > c.rows_end)
+    {
+      if (c.buffer.back() != '\n')
+      {
+        c.buffer += '\n';
+      }
+      scan(c, true);
+    }
+    if (c.rows > 0)
+    {
+      cut(c);
+    }
+    return false;
+  }
+
+  // Read enough for now, the rest is reported again
+  return true;
+}
+
+void SocketPoller::scan(Connection &c, bool force)
+{
+  size_t pos;
+  while ((pos = c.buffer.find('\n', c.scanned)) != std::string::npos)
+  {
+    // Leave the rest in the buffer until the processors caught up, see poll()
+    if (!force && backlogged())
+    {
+      return;
+    }
+
+    c.scanned = pos + 1;
+    if (c.header.empty())
+    {
+      c.header = c.buffer.substr(0, c.scanned);
+      c.buffer.erase(0, c.scanned);
+      c.scanned = 0;
+      continue;
+    }
+
+    if (c.rows++ == 0)
+    {
+      c.first_row = std::chrono::steady_clock::now();
+    }
+    c.rows_end = c.scanned;
+    if (c.rows >= m_batch_rows)
+    {
+      cut(c);
+    }
+  }
+  c.scanned = c.buffer.size();
+}
+
+void SocketPoller::cut(Connection &c)
+{
+  auto data = std::make_shared<std::string>();
+  data->reserve(c.header.size() + c.rows_end);
+  data->append(c.header);
+  data->append(c.buffer, 0, c.rows_end);
+  m_batches.emplace_back(c.id, PollResult("connection " + std::to_string(c.id), data, c.failed));
+
+  c.buffer.erase(0, c.rows_end);
+  c.scanned -= c.rows_end;
+  c.rows_end = 0;
+  c.rows = 0;
+}
+
+SafeQueue<PollResult> *SocketPoller::lane(size_t connection_id) const
+{
+  return m_lanes.empty() ? m_queue : m_lanes[connection_id % m_lanes.size()];
+}
+
+size_t SocketPoller::queued() const
+{
+  if (m_lanes.empty())
+  {
+    return m_queue->size();
+  }
+  size_t queued = 0;
+  for (auto *lane : m_lanes)
+  {
+    queued += lane->size();
+  }
+  return queued;
+}
+
+bool SocketPoller::backlogged() const
+{
+  return m_batches.size() + queued() >= m_max_queued_batches;
+}
+
+void SocketPoller::close_connection(int fd)
+{
+  LOG_INFO("Closed connection " + std::to_string(m_connections[fd].id), m_name);
+  epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+  close(fd);
+  m_connections.erase(fd);
+}
+
+AbstractPoller *SocketPoller::clone() const
+{
+  return new SocketPoller(*this);
+}
+
+void SocketPoller::clean()
+{
+  while (!m_connections.empty())
+  {
+    close_connection(m_connections.begin()->first);
+  }
+  if (m_epoll_fd >= 0)
+  {
+    close(m_epoll_fd);
+    m_epoll_fd = -1;
+  }
+  if (m_listen_fd >= 0)
+  {
+    close(m_listen_fd);
+    m_listen_fd = -1;
+    unlink(m_path.c_str());
+  }
+}
+
+SocketPoller::~SocketPoller()
+{
+  clean();
+}
+#endif
@@ -0,0 +1,76 @@
+#ifdef __linux__
+/**
+ * Poller accepting CSV streams from local clients on a Unix domain socket.
+ *
+ * Every connection sends a CSV with its own header line, then rows. An epoll loop reads all
+ * connections without blocking and cuts their complete rows into batches (the header plus up
+ * to batch_rows rows, or what arrived within max_delay_ms), which are queued for the processor
+ * pool like files. While max_queued_batches are waiting, the poller stops reading, so the
+ * clients block on full socket buffers instead of growing our memory. A connection whose rows
+ * could not be published is closed, so its client notices the loss.
+ *
+ * The batches of a connection all go to the same processor (picked by the connection id), so
+ * its rows are handled, and produced, in the order they were sent.
+ **/
+#ifndef SOCKET_POLLER_H
+#define SOCKET_POLLER_H
+
+#include "AbstractPoller.h"
+#include "impl/PollResult.h"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <string>
+
+class SocketPoller : public AbstractPoller
+{
+private:
+  struct Connection
+  {
+    size_t id;
+    std::string header;
+    std::string buffer;
+    size_t scanned = 0;    // bytes of the buffer searched for line ends
+    size_t rows_end = 0;   // end of the last complete row in the buffer
+    size_t rows = 0;       // complete rows in the buffer
+    std::chrono::steady_clock::time_point first_row;
+    // Set by a processor when rows of the connection could not be published
+    std::shared_ptr<std::atomic<bool>> failed = std::make_shared<std::atomic<bool>>(false);
+  };
+
+  PollResult poll() override;
+  void clean() override;
+  bool init_socket();
+  void accept_connections();
+  bool read_connection(int fd, Connection &c);
+  // Cuts the complete rows of the buffer into batches, unless backlogged() and not force
+  void scan(Connection &c, bool force = false);
+  void cut(Connection &c);
+  void close_connection(int fd);
+  SafeQueue<PollResult> *lane(size_t connection_id) const;
+  size_t queued() const;
+  // Cut and queued batches reached max_queued_batches
+  bool backlogged() const;
+
+  const std::string m_path;
+  const size_t m_batch_rows;
+  const std::chrono::milliseconds m_max_delay;
+  const size_t m_max_queued_batches;
+
+  int m_listen_fd = -1;
+  int m_epoll_fd = -1;
+  size_t m_connection_count = 0;
+  std::map<int, Connection> m_connections;
+  // Cut batches with the id of their connection
+  std::deque<std::pair<size_t, PollResult>> m_batches;
+
+public:
+  SocketPoller(std::string name, std::string path, size_t batch_rows, int max_delay_ms, size_t max_queued_batches, std::shared_ptr<SignalChannel> sig_channel);
+  ~SocketPoller() override;
+  AbstractPoller *clone() const override;
+  bool pinned() const override { return true; }
+};
+
+#endif
+#endif
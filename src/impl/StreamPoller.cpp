@@ -0,0 +1,27 @@
+#include "StreamPoller.h"
+#include "logging/Logging.h"
+
+StreamPoller::StreamPoller(std::string name, std::string path, std::shared_ptr<SignalChannel> sig_channel) : AbstractPoller(name, sig_channel), m_path(path)
+{
+}
+
+PollResult StreamPoller::poll()
+{
+  if (m_handed_out)
+  {
+    return PollResult("");
+  }
+
+  m_handed_out = true;
+  LOG_DEBUG("Handing out '" + m_path + "'", m_name);
+  return PollResult(m_path);
+}
+
+void StreamPoller::clean()
+{
+}
+
+AbstractPoller *StreamPoller::clone() const
+{
+  return new StreamPoller(*this);
+}
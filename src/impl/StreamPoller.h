@@ -0,0 +1,26 @@
+/**
+ * Poller for streaming input: hands the stream (stdin as '-' or the path of a named pipe)
+ * to one processor, once. The processor reads it until the end (stdin) or until shutdown
+ * (named pipes are reopened for the next writer).
+ **/
+#ifndef STREAM_POLLER_H
+#define STREAM_POLLER_H
+
+#include "AbstractPoller.h"
+#include "impl/PollResult.h"
+#include <string>
+
+class StreamPoller : public AbstractPoller
+{
+private:
+  PollResult poll() override;
+  void clean() override;
+  const std::string m_path;
+  bool m_handed_out = false;
+
+public:
+  StreamPoller(std::string name, std::string path, std::shared_ptr<SignalChannel> sig_channel);
+  AbstractPoller *clone() const override;
+};
+
+#endif
@@ -19,30 +19,33 @@ bool Util::str_ends_with(const char *str, const char *suffix)
     return 0 == strncmp(str + str_len - suffix_len, suffix, suffix_len);
 }
 
-avro::GenericDatum Util::create_datum_for_type(const std::string &value, const std::string &type)
+avro::GenericDatum Util::create_datum_for_type(std::string_view value, const std::string &type)
 {
     if (!type.compare("string"))
     {
-        return avro::GenericDatum(value);
+        return avro::GenericDatum(std::string(value));
     }
-    else if (!type.compare("float"))
+
+    // Numbers are short enough for the small string buffer, no allocation
+    std::string number(value);
+    if (!type.compare("float"))
     {
-        return avro::GenericDatum(std::stof(value));
+        return avro::GenericDatum(std::stof(number));
     }
     else if (!type.compare("double"))
     {
-        return avro::GenericDatum(std::stod(value));
+        return avro::GenericDatum(std::stod(number));
     }
     else if (!type.compare("int"))
     {
-        return avro::GenericDatum(std::stoi(value));
+        return avro::GenericDatum(std::stoi(number));
     }
     else if (!type.compare("long"))
     {
 #ifdef __linux__
-        return avro::GenericDatum(std::stol(value));
+        return avro::GenericDatum(std::stol(number));
 #elif __APPLE__
-        return avro::GenericDatum(strtoll(value.c_str(), NULL, 10));
+        return avro::GenericDatum(strtoll(number.c_str(), NULL, 10));
 #endif
     }
     else
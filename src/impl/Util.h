@@ -2,6 +2,7 @@
 #define UTILS_H
 
 #include <string>
+#include <string_view>
 #include <avro/Generic.hh>
 #include <exception>
 #include <stdexcept>
@@ -10,7 +11,7 @@ namespace Util
 {
 
     bool str_ends_with(const char *str, const char *suffix);
-    avro::GenericDatum create_datum_for_type(const std::string &value, const std::string &type);
+    avro::GenericDatum create_datum_for_type(std::string_view value, const std::string &type);
     std::string what(const std::exception_ptr &eptr);
 };
 
@@ -0,0 +1,347 @@
+#include "DecompressingStreamBuf.h"
+#include <cstring>
+#include <stdexcept>
+#include <zlib.h>
+#include <zstd.h>
+#include <lz4frame.h>
+
+/**
+ * gzip (and zlib) via zlib. Handles files made of several concatenated gzip members.
+ **/
+class GzipDecoder : public Decoder
+{
+private:
+    z_stream m_zs{};
+    // Between gzip members, i.e. the input may end here
+    bool m_complete = true;
+
+public:
+    GzipDecoder()
+    {
+        // 15 window bits + 32: detect gzip or zlib header automatically
+        if (inflateInit2(&m_zs, 15 + 32) != Z_OK)
+        {
+            throw std::runtime_error("inflateInit2 failed");
+        }
+    }
+
+    ~GzipDecoder() override
+    {
+        inflateEnd(&m_zs);
+    }
+
+    void decode(const char *in, size_t len, std::vector<char> &out) override
+    {
+        m_zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in));
+        m_zs.avail_in = static_cast<uInt>(len);
+
+        while (m_zs.avail_in > 0)
+        {
+            size_t pos = out.size();
+            out.resize(pos + std::max<size_t>(len * 4, 64 * 1024));
+            m_zs.next_out = reinterpret_cast<Bytef *>(&out[pos]);
+            m_zs.avail_out = static_cast<uInt>(out.size() - pos);
+
+            int ret = inflate(&m_zs, Z_NO_FLUSH);
+            out.resize(out.size() - m_zs.avail_out);
+
+            if (ret == Z_STREAM_END)
+            {
+                // Next gzip member (if any)
+                inflateReset(&m_zs);
+                m_complete = true;
+            }
+            else if (ret != Z_OK && ret != Z_BUF_ERROR)
+            {
+                throw std::runtime_error(std::string("gzip: ") + (m_zs.msg ? m_zs.msg : "inflate failed"));
+            }
+            else
+            {
+                m_complete = false;
+            }
+        }
+    }
+
+    void finish() override
+    {
+        if (!m_complete)
+        {
+            throw std::runtime_error("gzip: truncated input");
+        }
+    }
+};
+
+class ZstdDecoder : public Decoder
+{
+private:
+    ZSTD_DStream *m_zds;
+    // Last return value of ZSTD_decompressStream(), 0 once a frame is complete and flushed
+    size_t m_last_ret = 0;
+
+public:
+    ZstdDecoder() : m_zds(ZSTD_createDStream())
+    {
+        if (!m_zds || ZSTD_isError(ZSTD_initDStream(m_zds)))
+        {
+            throw std::runtime_error("ZSTD_initDStream failed");
+        }
+    }
+
+    ~ZstdDecoder() override
+    {
+        ZSTD_freeDStream(m_zds);
+    }
+
+    void decode(const char *in, size_t len, std::vector<char> &out) override
+    {
+        ZSTD_inBuffer input = {in, len, 0};
+        bool output_full = false;
+        // A full output buffer may leave decompressed data behind in the decoder
+        while (input.pos < input.size || output_full)
+        {
+            size_t pos = out.size();
+            out.resize(pos + ZSTD_DStreamOutSize());
+            ZSTD_outBuffer output = {&out[pos], out.size() - pos, 0};
+
+            size_t ret = ZSTD_decompressStream(m_zds, &output, &input);
+            out.resize(pos + output.pos);
+
+            if (ZSTD_isError(ret))
+            {
+                throw std::runtime_error(std::string("zstd: ") + ZSTD_getErrorName(ret));
+            }
+            m_last_ret = ret;
+            output_full = output.pos == output.size;
+        }
+    }
+
+    void finish() override
+    {
+        if (m_last_ret != 0)
+        {
+            throw std::runtime_error("zstd: truncated input");
+        }
+    }
+};
+
+class Lz4Decoder : public Decoder
+{
+private:
+    LZ4F_dctx *m_dctx;
+    // Last return value of LZ4F_decompress(), 0 once a frame is complete and flushed
+    size_t m_last_ret = 0;
+
+public:
+    Lz4Decoder()
+    {
+        if (LZ4F_isError(LZ4F_createDecompressionContext(&m_dctx, LZ4F_VERSION)))
+        {
+            throw std::runtime_error("LZ4F_createDecompressionContext failed");
+        }
+    }
+
+    ~Lz4Decoder() override
+    {
+        LZ4F_freeDecompressionContext(m_dctx);
+    }
+
+    void decode(const char *in, size_t len, std::vector<char> &out) override
+    {
+        size_t consumed = 0;
+        bool output_full = false;
+        // A full output buffer may leave decompressed data behind in the decoder
+        while (consumed < len || output_full)
+        {
+            size_t pos = out.size();
+            out.resize(pos + 256 * 1024);
+
+            size_t capacity = out.size() - pos;
+            size_t dst_size = capacity;
+            size_t src_size = len - consumed;
+            size_t ret = LZ4F_decompress(m_dctx, &out[pos], &dst_size, in + consumed, &src_size, nullptr);
+            out.resize(pos + dst_size);
+            consumed += src_size;
+
+            if (LZ4F_isError(ret))
+            {
+                throw std::runtime_error(std::string("lz4: ") + LZ4F_getErrorName(ret));
+            }
+            m_last_ret = ret;
+            output_full = dst_size == capacity;
+        }
+    }
+
+    void finish() override
+    {
+        if (m_last_ret != 0)
+        {
+            throw std::runtime_error("lz4: truncated input");
+        }
+    }
+};
+
+DecompressingStreamBuf::DecompressingStreamBuf(const std::string &path, Compression compression) : m_file(fopen(path.c_str(), "rb"))
+{
+    setg(nullptr, nullptr, nullptr);
+
+    if (!m_file)
+    {
+        m_error = "Unable to open '" + path + "': " + strerror(errno);
+        m_eof = true;
+        return;
+    }
+
+    switch (compression)
+    {
+    case Compression::GZIP:
+        m_decoder = std::make_unique<GzipDecoder>();
+        break;
+    case Compression::ZSTD:
+        m_decoder = std::make_unique<ZstdDecoder>();
+        break;
+    case Compression::LZ4:
+        m_decoder = std::make_unique<Lz4Decoder>();
+        break;
+    default:
+        break;
+    }
+
+    m_t = std::thread(&DecompressingStreamBuf::run, this);
+}
+
+Compression DecompressingStreamBuf::detect(const std::string &path)
+{
+    unsigned char magic[4] = {0};
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f)
+    {
+        return Compression::NONE;
+    }
+    size_t n = fread(magic, 1, sizeof(magic), f);
+    fclose(f);
+
+    if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+    {
+        return Compression::GZIP;
+    }
+    if (n == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+    {
+        return Compression::ZSTD;
+    }
+    if (n == 4 && magic[0] == 0x04 && magic[1] == 0x22 && magic[2] == 0x4d && magic[3] == 0x18)
+    {
+        return Compression::LZ4;
+    }
+    return Compression::NONE;
+}
+
+void DecompressingStreamBuf::run()
+{
+    std::vector<char> in(READ_CHUNK_SIZE);
+    try
+    {
+        size_t n;
+        while ((n = fread(in.data(), 1, in.size(), m_file)) > 0)
+        {
+            std::vector<char> out;
+            if (m_decoder)
+            {
+                m_decoder->decode(in.data(), n, out);
+            }
+            else
+            {
+                out.assign(in.begin(), in.begin() + n);
+            }
+
+            if (out.empty())
+            {
+                continue;
+            }
+
+            std::unique_lock lock(m_mutex);
+            m_cv.wait(lock, [this]()
+                      { return m_stop || m_chunks.size() < MAX_QUEUED_CHUNKS; });
+            if (m_stop)
+            {
+                return;
+            }
+            m_chunks.push_back(std::move(out));
+            m_cv.notify_all();
+        }
+
+        if (ferror(m_file))
+        {
+            throw std::runtime_error(std::string("read failed: ") + strerror(errno));
+        }
+
+        if (m_decoder)
+        {
+            m_decoder->finish();
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::unique_lock lock(m_mutex);
+        m_error = e.what();
+    }
+
+    std::unique_lock lock(m_mutex);
+    m_eof = true;
+    m_cv.notify_all();
+}
+
+DecompressingStreamBuf::int_type DecompressingStreamBuf::underflow()
+{
+    if (gptr() < egptr())
+    {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    {
+        std::unique_lock lock(m_mutex);
+        m_cv.wait(lock, [this]()
+                  { return !m_chunks.empty() || m_eof; });
+
+        if (m_chunks.empty())
+        {
+            if (!m_error.empty())
+            {
+                // Reported as badbit by the istream
+                throw std::runtime_error(m_error);
+            }
+            return traits_type::eof();
+        }
+
+        m_current = std::move(m_chunks.front());
+        m_chunks.pop_front();
+        m_cv.notify_all();
+    }
+
+    setg(m_current.data(), m_current.data(), m_current.data() + m_current.size());
+    return traits_type::to_int_type(*gptr());
+}
+
+std::string DecompressingStreamBuf::error()
+{
+    std::unique_lock lock(m_mutex);
+    return m_error;
+}
+
+DecompressingStreamBuf::~DecompressingStreamBuf()
+{
+    {
+        std::unique_lock lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+
+    if (m_t.joinable())
+    {
+        m_t.join();
+    }
+
+    if (m_file)
+    {
+        fclose(m_file);
+    }
+}
@@ -0,0 +1,89 @@
+/**
+ * Stream buffer that decompresses a gzip, zstd or lz4 (frame format) file on a dedicated
+ * reader thread. The reader thread reads large compressed chunks from disk, decompresses
+ * them and hands the decompressed chunks over through a small bounded queue, so that
+ * decompression overlaps with the CSV parsing done by the consuming thread.
+ *
+ * Errors on the reader thread surface as a failed underflow(), i.e. the istream using this
+ * buffer gets its badbit set. error() returns the reason. Input that ends before the end of
+ * the compressed stream is an error ("truncated input").
+ **/
+#ifndef DECOMPRESSING_STREAM_BUF_H
+#define DECOMPRESSING_STREAM_BUF_H
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class Compression
+{
+    NONE,
+    GZIP,
+    ZSTD,
+    LZ4
+};
+
+class Decoder
+{
+public:
+    virtual ~Decoder(){};
+
+    /**
+     * Consume all of in and append the decompressed bytes to out.
+     **/
+    virtual void decode(const char *in, size_t len, std::vector<char> &out) = 0;
+
+    /**
+     * Called at the end of the input. Throws if the input ended in the middle of a stream.
+     **/
+    virtual void finish() = 0;
+};
+
+class DecompressingStreamBuf : public std::streambuf
+{
+public:
+    DecompressingStreamBuf(const std::string &path, Compression compression);
+    DecompressingStreamBuf(const DecompressingStreamBuf &) = delete;
+    void operator=(const DecompressingStreamBuf &) = delete;
+    ~DecompressingStreamBuf() override;
+
+    std::string error();
+
+    /**
+     * Detect the compression of a file from its magic bytes.
+     **/
+    static Compression detect(const std::string &path);
+
+protected:
+    int_type underflow() override;
+
+private:
+    // Size of the compressed chunks read from disk
+    static constexpr size_t READ_CHUNK_SIZE = 1 << 20;
+
+    // Number of decompressed chunks the reader thread may be ahead of the parser
+    static constexpr size_t MAX_QUEUED_CHUNKS = 4;
+
+    void run();
+
+    FILE *m_file;
+    std::unique_ptr<Decoder> m_decoder;
+    std::vector<char> m_current;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::vector<char>> m_chunks;
+    bool m_eof = false;
+    bool m_stop = false;
+    std::string m_error;
+
+    std::thread m_t;
+};
+
+#endif
@@ -0,0 +1,11 @@
+#include "InputFileStream.h"
+
+InputFileStream::InputFileStream(const std::string &path) : std::istream(nullptr), m_buf(path, DecompressingStreamBuf::detect(path))
+{
+    rdbuf(&m_buf);
+}
+
+std::string InputFileStream::error()
+{
+    return m_buf.error();
+}
@@ -0,0 +1,22 @@
+/**
+ * Input stream over a (possibly compressed) file. The compression is detected from the
+ * magic bytes of the file, so the file name does not matter (e.g. 'x.csv.gz_inprogress').
+ **/
+#ifndef INPUT_FILE_STREAM_H
+#define INPUT_FILE_STREAM_H
+
+#include "DecompressingStreamBuf.h"
+#include <istream>
+#include <string>
+
+class InputFileStream : public std::istream
+{
+private:
+    DecompressingStreamBuf m_buf;
+
+public:
+    InputFileStream(const std::string &path);
+    std::string error();
+};
+
+#endif
@@ -0,0 +1,19 @@
+/**
+ * Read-only stream buffer over memory owned by someone else (no copy, unlike std::istringstream).
+ **/
+#ifndef MEMORY_STREAM_BUF_H
+#define MEMORY_STREAM_BUF_H
+
+#include <streambuf>
+
+class MemoryStreamBuf : public std::streambuf
+{
+public:
+    MemoryStreamBuf(const char *data, size_t len)
+    {
+        char *begin = const_cast<char *>(data);
+        setg(begin, begin, begin + len);
+    }
+};
+
+#endif
@@ -0,0 +1,62 @@
+#include "PipeStreamBuf.h"
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+
+PipeStreamBuf::PipeStreamBuf(int fd, int idle_ms, std::function<bool()> on_idle) : m_fd(fd), m_idle_ms(idle_ms), m_on_idle(on_idle), m_buffer(READ_SIZE)
+{
+}
+
+std::string PipeStreamBuf::error()
+{
+    return m_error;
+}
+
+PipeStreamBuf::int_type PipeStreamBuf::underflow()
+{
+    if (gptr() < egptr())
+    {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    pollfd pfd{m_fd, POLLIN, 0};
+    while (true)
+    {
+        int ret = poll(&pfd, 1, m_idle_ms);
+        if (ret == 0)
+        {
+            if (!m_on_idle())
+            {
+                return traits_type::eof();
+            }
+            continue;
+        }
+        if (ret < 0 && errno != EINTR)
+        {
+            m_error = strerror(errno);
+            return traits_type::eof();
+        }
+        if (ret < 0)
+        {
+            continue;
+        }
+
+        // Readable, or the writer hung up (read() returns 0 then)
+        ssize_t n = read(m_fd, m_buffer.data(), m_buffer.size());
+        if (n > 0)
+        {
+            setg(m_buffer.data(), m_buffer.data(), m_buffer.data() + n);
+            return traits_type::to_int_type(*gptr());
+        }
+        if (n == 0)
+        {
+            return traits_type::eof();
+        }
+        if (errno != EAGAIN && errno != EINTR)
+        {
+            m_error = strerror(errno);
+            return traits_type::eof();
+        }
+    }
+}
@@ -0,0 +1,38 @@
+/**
+ * Stream buffer over a pipe (stdin or a named pipe) that never blocks for longer than idle_ms.
+ *
+ * Whenever no data arrived for idle_ms, on_idle() is called, e.g. to flush what was produced
+ * so far or to notice a shutdown. If it returns false, the stream ends as if the writer had
+ * closed it.
+ **/
+#ifndef PIPE_STREAM_BUF_H
+#define PIPE_STREAM_BUF_H
+
+#include <functional>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+class PipeStreamBuf : public std::streambuf
+{
+public:
+    PipeStreamBuf(int fd, int idle_ms, std::function<bool()> on_idle);
+    PipeStreamBuf(const PipeStreamBuf &) = delete;
+    void operator=(const PipeStreamBuf &) = delete;
+
+    std::string error();
+
+protected:
+    int_type underflow() override;
+
+private:
+    static constexpr size_t READ_SIZE = 64 * 1024;
+
+    const int m_fd;
+    const int m_idle_ms;
+    std::function<bool()> m_on_idle;
+    std::vector<char> m_buffer;
+    std::string m_error;
+};
+
+#endif
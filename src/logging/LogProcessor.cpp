@@ -1,12 +1,43 @@
 #include "Logging.h"
 #include "ThreadGuard.h"
+#include "trace/Trace.h"
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif __APPLE__
+#include <pthread.h>
+#include <pthread/qos.h>
+#endif
 
 static std::string name = "LogProcessor";
-SafeQueue<std::string> log_queue;
+Logging::LogQueue log_queue;
 
-Logging::LogProcessor::LogProcessor(std::atomic<size_t> *active_processors, std::condition_variable *log_cv, std::mutex *log_cv_mutex) : m_active_processors(active_processors),
-                                                                                                                                         m_log_cv(log_cv),
-                                                                                                                                         m_log_cv_mutex(log_cv_mutex)
+/**
+ * Lower the priority of the calling thread so that logging never competes with processing.
+ */
+static void lower_priority()
+{
+#ifdef __linux__
+    // CPU: only scheduled when nothing else wants to run
+    sched_param param{};
+    if (pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) != 0)
+    {
+        Logging::WARN("Unable to set the SCHED_IDLE scheduling policy", name);
+    }
+
+    // I/O: idle class (IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT) for this thread (IOPRIO_WHO_PROCESS, 0)
+    if (syscall(SYS_ioprio_set, 1, 0, 3 << 13) != 0)
+    {
+        Logging::WARN("Unable to set the idle I/O priority", name);
+    }
+#elif __APPLE__
+    pthread_set_qos_class_self_np(QOS_CLASS_BACKGROUND, 0);
+#endif
+}
+
+Logging::LogProcessor::LogProcessor()
 {
     // Logging::configure({{"type", "file"}, {"file_name", "flycatcher.log"}, {"reopen_interval", "1"}});
     // Logging::configure({{"type", "std_out"}});
@@ -24,68 +55,57 @@ void Logging::LogProcessor::join() const
     ThreadGuard g(*m_t);
 }
 
-void Logging::LogProcessor::run()
+void Logging::LogProcessor::write(std::vector<std::string> &messages, size_t dropped)
 {
-    m_should_run = true;
-    while (m_should_run)
+    if (dropped > 0)
     {
-        // Do not log when we have active processors. Processors have priority over logging.
-
-        {
-            /*
-            Without blocks log_lock doesn't release until the iteration ends. Right after that iteration ends,
-            it starts the next one. This means, we only have time between the destruction of log_lock and then
-            the initialization of log_lock in the next iteration. Since that happens as basically the next instruction
-            there basically isn't any time for CsvProcessor to acquire a lock on the mutex.
-            */
-
-            // Lock first, then check predicate, if false unlock and then wait
-            std::unique_lock log_lock(*m_log_cv_mutex);
-
-            /*
-            When it wakes up it tries to re-lock the mutex and check the
-            predicate.
-            */
-            m_log_cv->wait_for(log_lock, std::chrono::hours(1),
-                               /*
-                               When the condition variable is woken up (spurious or through notify_all())
-                               and this predicate returns true, the wait is stopped.
-                               */
-                               [this]()
-                               {
-                        bool stop_waiting = !m_active_processors->load();
-                        return stop_waiting; });
+        messages.emplace_back(create_log("Dropped " + std::to_string(dropped) + " log message(s), the log queue was full", Level::WARN, name));
+    }
+    if (messages.empty())
+    {
+        return;
+    }
+    TRACE_SPAN("LogProcessor::write");
 
-        } // wait() reacquired the lock on exit. So we release it here since there is no reason to hold it while printing.
+    // One write per batch
+    size_t len = 0;
+    for (const std::string &message : messages)
+    {
+        len += message.size();
+    }
+    std::string batch;
+    batch.reserve(len);
+    for (const std::string &message : messages)
+    {
+        batch.append(message);
+    }
+    Logging::log(batch);
+}
 
-        /*
-        Read and log
-        Important: after unlocking as we don't want to block strategies while waiting for dequeue if queue is empty
-        */
-        std::string message = log_queue.dequeue();
-        Logging::log(message);
+void Logging::LogProcessor::run()
+{
+    Trace::set_thread_name("LogProcessor");
+    lower_priority();
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::vector<std::string> messages;
+    while (m_should_run.load())
+    {
+        size_t dropped = log_queue.drain(messages, 100);
+        write(messages, dropped);
     } // end while
 
     Logging::log("Shutdown requested. Processing remaining " + std::to_string(log_queue.size()) + " messages...", Logging::Level::INFO, name);
-    std::string msg;
-    log_queue.dequeue_with_timeout(1000, msg);
-    while (!msg.empty())
-    {
-        Logging::log(msg, Logging::Level::INFO);
-        msg.clear();
-        log_queue.dequeue_with_timeout(1000, msg);
-    }
+    size_t dropped = log_queue.drain(messages, 0);
+    write(messages, dropped);
 
     Logging::log("Shutting down", Logging::Level::INFO, name);
 }
 
 void Logging::LogProcessor::stop()
 {
-    m_should_run = false;
+    m_should_run.store(false);
 }
 
 Logging::LogProcessor::~LogProcessor()
 {
-}
\ No newline at end of file
+}
@@ -0,0 +1,58 @@
+#include "LogQueue.h"
+
+Logging::LogQueue::LogQueue(size_t capacity) : m_capacity(capacity)
+{
+}
+
+void Logging::LogQueue::set_capacity(size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_capacity = capacity;
+}
+
+bool Logging::LogQueue::enqueue(std::string message, bool error)
+{
+    bool was_empty;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_bytes + message.size() > (error ? 2 * m_capacity : m_capacity))
+        {
+            ++m_dropped;
+            return false;
+        }
+
+        was_empty = m_messages.empty();
+        m_bytes += message.size();
+        m_messages.emplace_back(std::move(message));
+    }
+
+    // The LogProcessor takes everything at once, so it only needs a wakeup for the first message
+    if (was_empty)
+    {
+        m_cv.notify_one();
+    }
+    return true;
+}
+
+size_t Logging::LogQueue::drain(std::vector<std::string> &out, int timeout_ms)
+{
+    out.clear();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]()
+                  { return !m_messages.empty(); });
+
+    // Swap, so that both vectors keep their capacity and the lock is held only briefly
+    m_messages.swap(out);
+    m_bytes = 0;
+
+    size_t dropped = m_dropped;
+    m_dropped = 0;
+    return dropped;
+}
+
+size_t Logging::LogQueue::size()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_messages.size();
+}
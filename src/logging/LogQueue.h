@@ -0,0 +1,50 @@
+/**
+ * Queue of formatted log messages between the logging threads and the LogProcessor.
+ *
+ * Bounded by the bytes of the queued messages: when the LogProcessor can't keep up, new
+ * messages are dropped (and counted) instead of piling up in memory. Errors may use twice
+ * the capacity before they are dropped too. Producers never block on a full queue.
+ **/
+#ifndef LOG_QUEUE_H
+#define LOG_QUEUE_H
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Logging
+{
+    class LogQueue
+    {
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::vector<std::string> m_messages;
+        size_t m_bytes = 0;
+        size_t m_capacity;
+        size_t m_dropped = 0;
+
+    public:
+        LogQueue(size_t capacity = 16 * 1024 * 1024);
+        LogQueue(const LogQueue &) = delete;
+        void operator=(const LogQueue &) = delete;
+
+        void set_capacity(size_t capacity);
+
+        /**
+         * Returns false if the message was dropped.
+         **/
+        bool enqueue(std::string message, bool error = false);
+
+        /**
+         * Wait up to timeout_ms for messages and move all of them into out (cleared first).
+         * Returns the number of messages dropped since the last call.
+         **/
+        size_t drain(std::vector<std::string> &out, int timeout_ms);
+
+        size_t size();
+    };
+} // end namespace
+
+#endif
@@ -4,9 +4,8 @@
  **/
 #ifndef LOGGING_H
 #define LOGGING_H
-#define LOGGING_LEVEL_INFO
 
-#include "SafeQueue.h"
+#include "LogQueue.h"
 #include <string>
 #include <stdexcept>
 #include <iostream>
@@ -21,9 +20,11 @@
 #include <cstdlib>
 #include <thread>
 #include <atomic>
+#include <algorithm>
+#include <cctype>
 #include <spdlog/spdlog.h>
 
-extern SafeQueue<std::string> log_queue;
+extern Logging::LogQueue log_queue;
 
 namespace Logging
 {
@@ -49,10 +50,14 @@ namespace Logging
         {Level::DEBUG, " [DEBUG] "},
         {Level::TRACE, " [TRACE] "}};
 
-#if defined(LOGGING_LEVEL_ALL) || defined(LOGGING_LEVEL_TRACE)
-    constexpr Level LEVEL_CUTOFF = Level::TRACE;
-#elif defined(LOGGING_LEVEL_DEBUG)
+    /*
+    Compile-time cutoff: log sites below it are compiled out and can't be enabled at runtime.
+    Everything is compiled in by default, the runtime level (see set_level()) decides.
+    */
+#if defined(LOGGING_LEVEL_DEBUG)
     constexpr Level LEVEL_CUTOFF = Level::DEBUG;
+#elif defined(LOGGING_LEVEL_INFO)
+    constexpr Level LEVEL_CUTOFF = Level::INFO;
 #elif defined(LOGGING_LEVEL_WARN)
     constexpr Level LEVEL_CUTOFF = Level::WARN;
 #elif defined(LOGGING_LEVEL_ERROR)
@@ -60,27 +65,110 @@ namespace Logging
 #elif defined(LOGGING_LEVEL_NONE)
     constexpr Level LEVEL_CUTOFF = Level::ERROR + 1;
 #else
-    constexpr Level LEVEL_CUTOFF = Level::INFO;
+    constexpr Level LEVEL_CUTOFF = Level::TRACE;
 #endif
 
+    // Runtime level, INFO unless configured otherwise
+    inline std::atomic<Level> runtime_level{std::max(Level::INFO, LEVEL_CUTOFF)};
+
+    /**
+     * Whether messages of the level are logged. A relaxed atomic load, cheap enough for hot paths.
+     **/
+    inline bool enabled(const Level level)
+    {
+        return level >= LEVEL_CUTOFF && level >= runtime_level.load(std::memory_order_relaxed);
+    }
+
+    inline void set_level(const Level level)
+    {
+        runtime_level.store(std::max(level, LEVEL_CUTOFF), std::memory_order_relaxed);
+    }
+
+    inline Level level()
+    {
+        return runtime_level.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Level by its (case-insensitive) name: trace, debug, info, warn or error.
+     **/
+    inline bool parse_level(std::string name, Level &level)
+    {
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c)
+                       { return std::tolower(c); });
+        static const std::unordered_map<std::string, Level> levels{
+            {"trace", Level::TRACE},
+            {"debug", Level::DEBUG},
+            {"info", Level::INFO},
+            {"warn", Level::WARN},
+            {"error", Level::ERROR}};
+        auto it = levels.find(name);
+        if (it == levels.end())
+        {
+            return false;
+        }
+        level = it->second;
+        return true;
+    }
+
+    /**
+        Write value as width decimal digits, zero padded.
+    */
+    inline void write_digits(char *out, unsigned int value, int width)
+    {
+        for (int i = width - 1; i >= 0; --i)
+        {
+            out[i] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+    }
+
+    /**
+        Append the timestamp as: year/mo/dy hr:mn:sc.xxxxxx
+
+        gmtime_r() and the formatting of the date and time only run once per second and
+        thread, in between only the microseconds are written.
+    */
+    inline void append_timestamp(std::string &out)
+    {
+        static constexpr size_t LENGTH = sizeof("year/mo/dy hr:mn:sc.xxxxxx") - 1;
+        thread_local std::time_t cached_second = -1;
+        thread_local char cached[LENGTH];
+
+        auto since_epoch = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        std::time_t tt = static_cast<std::time_t>(since_epoch / 1000000); // Seconds since the Epoch
+        unsigned int microseconds = static_cast<unsigned int>(since_epoch % 1000000);
+
+        if (tt != cached_second)
+        {
+            std::tm gmt{};
+            gmtime_r(&tt, &gmt);
+            write_digits(cached, gmt.tm_year + 1900, 4);
+            cached[4] = '/';
+            write_digits(cached + 5, gmt.tm_mon + 1, 2);
+            cached[7] = '/';
+            write_digits(cached + 8, gmt.tm_mday, 2);
+            cached[10] = ' ';
+            write_digits(cached + 11, gmt.tm_hour, 2);
+            cached[13] = ':';
+            write_digits(cached + 14, gmt.tm_min, 2);
+            cached[16] = ':';
+            write_digits(cached + 17, gmt.tm_sec, 2);
+            cached[19] = '.';
+            cached_second = tt;
+        }
+        write_digits(cached + 20, microseconds, 6);
+
+        out.append(cached, LENGTH);
+    }
+
     /**
         Timestamp as: year/mo/dy hr:mn:sc.xxxxxx
     */
     inline std::string timestamp()
     {
-        std::chrono::system_clock::time_point tp = std::chrono::system_clock::now(); // Implementation dependant: microseconds or nanoseconds.
-        std::time_t tt = std::chrono::system_clock::to_time_t(tp);                   // Seconds since the Epoch
-        std::tm gmt{};
-        gmtime_r(&tt, &gmt);
-
-        // from_time_t(...) returns "rounded" value
-        // 1 microsecond = 0.000001 seconds
-        // 1 nanosecond = 0.000000001 seconds or 1000 000 000ns = 1s
-        // (1 668 496 399 029 524 297ns - 1 668 496 399 000 000 000ns) + gmt.tm_sec = 29 524 297ns + 19s = 19.029s
-        std::chrono::duration<double> fractional_seconds = (tp - std::chrono::system_clock::from_time_t(tt)) + std::chrono::seconds(gmt.tm_sec);
-
-        std::string buffer("year/mo/dy hr:mn:sc.xxxxxx");
-        sprintf(&buffer.front(), "%04d/%02d/%02d %02d:%02d:%09.6f", gmt.tm_year + 1900, gmt.tm_mon + 1, gmt.tm_mday, gmt.tm_hour, gmt.tm_min, fractional_seconds.count());
+        std::string buffer;
+        append_timestamp(buffer);
         return buffer;
     }
 
@@ -195,7 +283,7 @@ namespace Logging
 
         std::size_t len = name.length() + message.length() + 64;
         output.reserve(len);
-        output.append(timestamp());
+        append_timestamp(output);
         output.append(prefix.find(level)->second);
         output.append("[");
         output.append(name);
@@ -224,7 +312,7 @@ namespace Logging
 
     inline void TRACE(const std::string &message, const std::string &name = "")
     {
-        if (LEVEL_CUTOFF > Level::TRACE)
+        if (!enabled(Level::TRACE))
         {
             return;
         }
@@ -234,7 +322,7 @@ namespace Logging
 
     inline void DEBUG(const std::string &message, const std::string &name = "")
     {
-        if (LEVEL_CUTOFF > Level::DEBUG)
+        if (!enabled(Level::DEBUG))
         {
             return;
         }
@@ -245,7 +333,7 @@ namespace Logging
     inline void INFO(const std::string &message, const std::string &name = "")
     {
         // get_logger().log(message, Level::INFO);
-        if (LEVEL_CUTOFF > Level::INFO)
+        if (!enabled(Level::INFO))
         {
             return;
         }
@@ -255,7 +343,7 @@ namespace Logging
 
     inline void WARN(const std::string &message, const std::string &name = "")
     {
-        if (LEVEL_CUTOFF > Level::WARN)
+        if (!enabled(Level::WARN))
         {
             return;
         }
@@ -263,28 +351,50 @@ namespace Logging
         log_queue.enqueue(create_log(message, Level::WARN, name));
     }
 
-    // TODO: Give LogProccessor priority on ERROR so that we don't miss any errors
     inline void ERROR(const std::string &message, const std::string &name = "")
     {
-        log_queue.enqueue(create_log(message, Level::ERROR, name));
+        log_queue.enqueue(create_log(message, Level::ERROR, name), true);
     }
 
+} // end namespace
+
+/*
+Log sites that only build their message if the level is enabled, e.g.
+LOG_DEBUG("Enqueued " + std::to_string(n) + " message(s)", m_name). Prefer these over the
+functions above when the message is not a constant.
+*/
+#define LOG_AT(LEVEL, message, name)                       \
+    do                                                     \
+    {                                                      \
+        if (Logging::enabled(Logging::Level::LEVEL))       \
+        {                                                  \
+            Logging::LEVEL(message, name);                 \
+        }                                                  \
+    } while (0)
+#define LOG_TRACE(message, name) LOG_AT(TRACE, message, name)
+#define LOG_DEBUG(message, name) LOG_AT(DEBUG, message, name)
+#define LOG_INFO(message, name) LOG_AT(INFO, message, name)
+#define LOG_WARN(message, name) LOG_AT(WARN, message, name)
+
+namespace Logging
+{
     /**
      * Thread that picks up log events from the queue and actually logs them.
      *
+     * Runs at idle CPU and I/O priority, so it only uses what the processors leave over, and
+     * writes everything queued in one go. The queue is bounded (see LogQueue), so a busy
+     * system drops log messages rather than accumulating them.
      **/
     class LogProcessor
     {
     private:
-        bool m_should_run;
+        std::atomic<bool> m_should_run = true;
         std::unique_ptr<std::thread> m_t;
-        std::atomic<size_t> *m_active_processors;
-        std::condition_variable *m_log_cv;
-        std::mutex *m_log_cv_mutex;
         void run();
+        void write(std::vector<std::string> &messages, size_t dropped);
 
     public:
-        LogProcessor(std::atomic<size_t> *active_processors, std::condition_variable *log_cv, std::mutex *log_cv_mutex);
+        LogProcessor();
         ~LogProcessor();
         bool start();
         void join() const;
@@ -56,5 +56,11 @@ void Logging::SpdLogger::log(const std::string &message, const Level level)
 
 void Logging::SpdLogger::log(const std::string &message)
 {
-    m_logger->trace(message);
+    // The sinks terminate every message with a newline themselves
+    std::string_view view(message);
+    if (!view.empty() && view.back() == '\n')
+    {
+        view.remove_suffix(1);
+    }
+    m_logger->trace(view);
 }
\ No newline at end of file
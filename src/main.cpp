@@ -5,9 +5,26 @@
 #include "impl/CsvProcessor.h"
 #include "impl/CsvProcessorBuilder.h"
 #include "impl/DirectoryPollerBuilder.h"
+#include "impl/StreamPoller.h"
+#ifdef __linux__
+#include "impl/SocketPoller.h"
+#endif
 #include "impl/KafkaPoller.h"
 #include "impl/KafkaDeliveryReportCb.h"
+#include "impl/KafkaEventCb.h"
+#include "impl/KafkaConf.h"
+#include "impl/InFlightBudget.h"
+#include "impl/KafkaPartitioner.h"
+#include "impl/SchemaIdCache.h"
+#include "impl/FileReport.h"
+#include "sinks/KafkaSink.h"
+#include "sinks/OcfSink.h"
+#include "sinks/NullSink.h"
+#include "sinks/CountingSink.h"
 #include "config/ConfigParser.h"
+#include "metrics/Metrics.h"
+#include "metrics/MetricsExporter.h"
+#include "trace/Trace.h"
 #include <librdkafka/rdkafkacpp.h>
 #ifdef __linux__
 #include "impl/DirectoryPoller.h"
@@ -18,9 +35,12 @@
 #include <yaml-cpp/yaml.h>
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <getopt.h>
 #include <signal.h>
+#include <functional>
+#include <set>
 #include <future> // for async()
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -37,7 +57,9 @@ void usage(const std::string me)
                                   "Produces Avro encoded messages to Kafka from CSV objects\n"
                                   "\n"
                                   "Options:\n"
-                                  " -d <directory>    Watch directory\n"
+                                  " -d <directory>    Watch directory, in addition to the 'directories' of the configuration\n"
+                                  " -s <pipe>         Stream CSV from a named pipe or stdin ('-') instead\n"
+                                  " -u <socket>       Accept CSV streams on a Unix domain socket instead (Linux)\n"
                                   " -c <config>       Configuration file\n"
                                   "\n"
                                   "\n"
@@ -48,10 +70,10 @@ void usage(const std::string me)
 }
 
 /**
- * Create a return a shared channel for SIGINT signals.
+ * Create a return a shared channel for SIGINT signals. SIGHUP and SIGUSR1 call on_signal instead.
  *
  */
-std::shared_ptr<SignalChannel> listen_for_sigint(sigset_t &sigset)
+std::shared_ptr<SignalChannel> listen_for_sigint(sigset_t &sigset, std::function<void(int)> on_signal)
 {
   std::shared_ptr<SignalChannel> sig_channel = std::make_shared<SignalChannel>();
 
@@ -60,15 +82,20 @@ std::shared_ptr<SignalChannel> listen_for_sigint(sigset_t &sigset)
   sigemptyset(&sigset);
   sigaddset(&sigset, SIGINT);
   sigaddset(&sigset, SIGTERM);
+  sigaddset(&sigset, SIGHUP);
+  sigaddset(&sigset, SIGUSR1);
   pthread_sigmask(SIG_BLOCK, &sigset, nullptr);
 
   std::thread signal_handler{
-      [&sig_channel, &sigset]()
+      [sig_channel, &sigset, on_signal]()
       {
         int signum = 0;
 
         // wait untl a signal is delivered
-        sigwait(&sigset, &signum);
+        while (sigwait(&sigset, &signum) == 0 && (signum == SIGHUP || signum == SIGUSR1))
+        {
+          on_signal(signum);
+        }
         sig_channel->m_shutdown_requested.store(true);
 
         // notify all waiting workers to check their predicate
@@ -79,19 +106,23 @@ std::shared_ptr<SignalChannel> listen_for_sigint(sigset_t &sigset)
   signal_handler.detach();
 #elif __APPLE__
   std::thread signal_handler{
-      [&sig_channel]()
+      [sig_channel, on_signal]()
       {
         int kq = kqueue();
 
-        /* Two kevent structs */
-        struct kevent *ke = (struct kevent *)malloc(sizeof(struct kevent));
+        /* Three kevent structs */
+        struct kevent *ke = (struct kevent *)malloc(3 * sizeof(struct kevent));
 
-        /* Initialise struct for SIGINT */
+        /* Initialise structs for SIGINT, SIGHUP and SIGUSR1 */
         signal(SIGINT, SIG_IGN);
-        EV_SET(ke, SIGINT, EVFILT_SIGNAL, EV_ADD, 0, 0, NULL);
+        signal(SIGHUP, SIG_IGN);
+        signal(SIGUSR1, SIG_IGN);
+        EV_SET(&ke[0], SIGINT, EVFILT_SIGNAL, EV_ADD, 0, 0, NULL);
+        EV_SET(&ke[1], SIGHUP, EVFILT_SIGNAL, EV_ADD, 0, 0, NULL);
+        EV_SET(&ke[2], SIGUSR1, EVFILT_SIGNAL, EV_ADD, 0, 0, NULL);
 
         /* Register for the events */
-        if (kevent(kq, ke, 1, NULL, 0, NULL) < 0)
+        if (kevent(kq, ke, 3, NULL, 0, NULL) < 0)
         {
           perror("kevent");
           return false;
@@ -100,9 +131,10 @@ std::shared_ptr<SignalChannel> listen_for_sigint(sigset_t &sigset)
         memset(ke, 0x00, sizeof(struct kevent));
 
         // Camp here for event
-        if (kevent(kq, NULL, 0, ke, 1, NULL) < 0)
+        while (kevent(kq, NULL, 0, ke, 1, NULL) >= 0 && ke->filter == EVFILT_SIGNAL && (ke->ident == SIGHUP || ke->ident == SIGUSR1))
         {
-          perror("kevent");
+          on_signal(ke->ident);
+          memset(ke, 0x00, sizeof(struct kevent));
         }
 
         switch (ke->filter)
@@ -124,20 +156,97 @@ std::shared_ptr<SignalChannel> listen_for_sigint(sigset_t &sigset)
   return sig_channel;
 }
 
+/**
+ * Apply the log level of the configuration file. Called at startup and on SIGHUP.
+ *
+ */
+void apply_log_level(const std::string &config_file)
+{
+  try
+  {
+    std::string level_name = ConfigParser::instance(config_file).log_level();
+    Logging::Level level;
+    if (!Logging::parse_level(level_name, level))
+    {
+      Logging::ERROR("Unknown log level '" + level_name + "'. Valid levels are: trace, debug, info, warn, error", name);
+      return;
+    }
+
+    if (level != Logging::level())
+    {
+      Logging::set_level(level);
+
+      // Always shown, whatever the new level
+      log_queue.enqueue(Logging::create_log("Log level set to '" + level_name + "'", Logging::Level::INFO, name));
+    }
+  }
+  catch (const std::exception &e)
+  {
+    Logging::ERROR("Unable to read the log level: " + std::string(e.what()), name);
+  }
+}
+
+/**
+ * Write the trace file. Called on SIGUSR1 and at shutdown.
+ *
+ */
+void dump_trace()
+{
+  if (!Trace::enabled.load())
+  {
+    Logging::WARN("Tracing is not enabled, add a 'trace' section to the configuration", name);
+  }
+  else if (Trace::dump())
+  {
+    Logging::INFO("Wrote trace", name);
+  }
+  else
+  {
+    Logging::ERROR("Unable to write the trace", name);
+  }
+}
+
+/**
+ * Load the schemas, transformers, filters, max age and routes of a profile.
+ *
+ */
+Profile load_profile(ConfigParser &config, SchemaIdCache *schema_cache, bool resolve_ids)
+{
+  Profile profile;
+  profile.schemas = config.schemas(schema_cache, resolve_ids);
+  profile.transformers = config.transformers();
+  profile.filters = config.filters();
+
+  // Only the columns referenced by the configuration are materialised by the CSV parser
+  profile.projection = config.required_columns();
+  if (config.has_key("max_age"))
+  {
+    profile.max_age = config.max_age();
+  }
+  profile.routes = config.routes(profile.schemas);
+  return profile;
+}
+
 /**
  * Parse commandline arguments and fill in config file path and directory to watch.
  *
  */
-void parse_args(int argc, char *argv[], std::string &config_file, std::string &dir_to_watch)
+void parse_args(int argc, char *argv[], std::string &config_file, std::string &dir_to_watch, std::string &stream_path, std::string &socket_path)
 {
   int opt;
-  while ((opt = getopt(argc, argv, "d:c:")) != -1)
+  while ((opt = getopt(argc, argv, "d:s:u:c:")) != -1)
   {
     switch (opt)
     {
     case 'd':
       dir_to_watch = optarg;
       break;
+    case 's':
+      stream_path = optarg;
+      break;
+    case 'u':
+      socket_path = optarg;
+      break;
     case 'c':
       config_file = optarg;
       break;
@@ -147,12 +256,34 @@ void parse_args(int argc, char *argv[], std::string &config_file, std::string &d
     }
   }
 
-  if (dir_to_watch.empty())
+  if ((!dir_to_watch.empty()) + (!stream_path.empty()) + (!socket_path.empty()) > 1)
   {
-    std::cerr << "Directory to watch cannot be empty" << std::endl;
+    std::cerr << "Only one of a directory to watch, a stream or a socket can be given" << std::endl;
     exit(1);
   }
-  else
+
+  if (!socket_path.empty())
+  {
+#ifndef __linux__
+    std::cerr << "Socket input is only supported on Linux" << std::endl;
+    exit(1);
+#endif
+  }
+  else if (!stream_path.empty())
+  {
+    struct stat info;
+    if (stream_path.compare("-") && stat(stream_path.c_str(), &info) != 0)
+    {
+      std::cerr << "Cannot access '" << stream_path << "'" << std::endl;
+      exit(1);
+    }
+    else if (stream_path.compare("-") && !S_ISFIFO(info.st_mode))
+    {
+      std::cerr << "'" << stream_path << "' is not a named pipe" << std::endl;
+      exit(1);
+    }
+  }
+  else if (!dir_to_watch.empty())
   {
     struct stat info;
     if (stat(dir_to_watch.c_str(), &info) != 0)
@@ -192,13 +323,15 @@ int main(int argc, char *argv[])
 {
   std::string config_file;
   std::string dir_to_watch;
+  std::string stream_path;
+  std::string socket_path;
 
   /*************************************************************************
    *
    * COMMANDLINE ARGUMENTS
    *
    *************************************************************************/
-  parse_args(argc, argv, config_file, dir_to_watch);
+  parse_args(argc, argv, config_file, dir_to_watch, stream_path, socket_path);
 
   /*************************************************************************
    *
@@ -206,17 +339,23 @@ int main(int argc, char *argv[])
    *
    *************************************************************************/
   sigset_t sigset;
-  std::shared_ptr<SignalChannel> sig_channel = listen_for_sigint(sigset);
+  std::shared_ptr<SignalChannel> sig_channel = listen_for_sigint(sigset, [config_file](int signum)
+                                                                {
+                                                                  if (signum == SIGUSR1)
+                                                                  {
+                                                                    dump_trace();
+                                                                  }
+                                                                  else
+                                                                  {
+                                                                    apply_log_level(config_file);
+                                                                  } });
 
   /*************************************************************************
    *
    * LOGGER
    *
    *************************************************************************/
-  std::atomic<size_t> active_processors = 0;
-  std::condition_variable log_cv;
-  std::mutex log_cv_mutex;
-  Logging::LogProcessor log_processor(&active_processors, &log_cv, &log_cv_mutex);
+  Logging::LogProcessor log_processor;
 
   log_processor.start();
 
@@ -226,26 +365,128 @@ int main(int argc, char *argv[])
    *
    *************************************************************************/
   ConfigParser &config = ConfigParser::instance(config_file);
+  apply_log_level(config_file);
+  if (config.log_queue_bytes() > 0)
+  {
+    log_queue.set_capacity(config.log_queue_bytes());
+  }
+
+  /*************************************************************************
+   *
+   * METRICS
+   *
+   *************************************************************************/
+  Metrics::Registry::instance().gauge("flycatcher_log_queue_length", "Log messages waiting to be written", []()
+                                      { return static_cast<double>(log_queue.size()); });
+
+  // Chrome trace of the hot path, written on SIGUSR1 (kill -USR1 <pid>) and optionally at shutdown
+  std::map<std::string, std::string> trace_config = config.trace();
+  bool dump_trace_on_exit = !trace_config["dump_on_exit"].compare("true");
+  if (trace_config.find("file") != trace_config.end())
+  {
+    size_t events_per_thread = trace_config.find("events_per_thread") != trace_config.end() ? std::stoul(trace_config["events_per_thread"]) : 65536;
+    Trace::configure(events_per_thread, trace_config["file"]);
+    Logging::INFO("Tracing the last " + std::to_string(events_per_thread) + " spans per thread into '" + trace_config["file"] + "'", name);
+  }
+
+  // Prometheus endpoint on a local port or Unix domain socket, e.g. 127.0.0.1:9464 or /run/flycatcher.sock
+  std::map<std::string, std::string> metrics_config = config.metrics();
+  std::unique_ptr<MetricsExporter> metrics_exporter;
+  if (metrics_config.find("listen") != metrics_config.end())
+  {
+    metrics_exporter = std::make_unique<MetricsExporter>(metrics_config["listen"], sig_channel);
+    if (!metrics_exporter->start())
+    {
+      Logging::ERROR("Unable to serve metrics on '" + metrics_config["listen"] + "'", name);
+      kill(getpid(), SIGINT);
+    }
+  }
 
   /*************************************************************************
    *
    * KAFKA
    *
    *************************************************************************/
-  std::map<std::string, SchemaConfig> schemas = config.schemas();
   std::map<std::string, std::string> kafka_config = config.kafka();
 
-  RdKafka::Conf *conf = RdKafka::Conf::create(RdKafka::Conf::CONF_GLOBAL);
-  std::string errstr;
-  if (conf->set("bootstrap.servers", kafka_config["bootstrap.servers"], errstr) != RdKafka::Conf::CONF_OK)
+  /* Sink of the processors:
+   *  kafka    - produce to Kafka (default)
+   *  ocf      - write Avro Object Container Files to 'directory'
+   *  null     - discard, to measure the pipeline without a broker
+   *  counting - discard, but report the messages per topic at shutdown */
+  std::map<std::string, std::string> sink_config = config.sink();
+  std::string sink_type = sink_config.find("type") != sink_config.end() ? sink_config["type"] : "kafka";
+  bool kafka_sink = !sink_type.compare("kafka");
+  if (!kafka_sink && sink_type.compare("ocf") && sink_type.compare("null") && sink_type.compare("counting"))
   {
-    Logging::ERROR(errstr, name);
+    Logging::ERROR("Unknown sink type '" + sink_type + "'", name);
     kill(getpid(), SIGINT);
   }
-  if (conf->set("client.id", kafka_config["client.id"], errstr) != RdKafka::Conf::CONF_OK)
+
+  // Optional local cache of schema ids, so that a restart doesn't need the registry
+  std::unique_ptr<SchemaIdCache> schema_cache;
+  if (kafka_config.find("schema.registry.cache") != kafka_config.end())
   {
-    Logging::ERROR(errstr, name);
+    schema_cache = std::make_unique<SchemaIdCache>(kafka_config["schema.registry.cache"]);
+  }
+
+  /* Directories to watch: -d and the 'directories' of the configuration, which may process their
+   * files with a named profile. All of them share the processors and producers. */
+  std::vector<DirectoryConfig> directories;
+  if (stream_path.empty() && socket_path.empty())
+  {
+    directories = config.directories(dir_to_watch);
+    if (directories.empty())
+    {
+      std::cerr << "Directory to watch cannot be empty" << std::endl;
+      exit(1);
+    }
+  }
+  else if (config.has_key("directories"))
+  {
+    Logging::WARN("Ignoring 'directories' of the configuration when reading a stream or socket", name);
+  }
+
+  // The top-level configuration is the default profile, only loaded if something uses it
+  std::map<std::string, Profile> profiles;
+  if (directories.empty() || std::any_of(directories.begin(), directories.end(), [](const DirectoryConfig &d)
+                                         { return d.profile.empty(); }))
+  {
+    profiles.emplace("", load_profile(config, schema_cache.get(), kafka_sink));
+  }
+  for (const DirectoryConfig &directory : directories)
+  {
+    if (!directory.profile.empty() && profiles.find(directory.profile) == profiles.end())
+    {
+      Logging::INFO("Loading profile '" + directory.profile + "'", name);
+      profiles.emplace(directory.profile, load_profile(*config.profile(directory.profile), schema_cache.get(), kafka_sink));
+    }
+  }
+
+  // Topics of all profiles. Profiles publishing to the same topic must agree on its schema.
+  std::map<std::string, SchemaConfig> schemas;
+  for (const auto &[profile_name, profile] : profiles)
+  {
+    for (const auto &[topic, schema_config] : profile.schemas)
+    {
+      auto [it, inserted] = schemas.emplace(topic, schema_config);
+      if (!inserted && SchemaIdCache::fingerprint(it->second.schema) != SchemaIdCache::fingerprint(schema_config.schema))
+      {
+        Logging::ERROR("Profiles use different schemas for topic '" + topic + "'", name);
+        kill(getpid(), SIGINT);
+      }
+    }
+  }
+
+  std::string errstr;
+  RdKafka::Conf *conf = KafkaConf::create(kafka_config, errstr);
+  if (!conf)
+  {
+    // Nothing works without a valid producer configuration. Continue with the defaults until
+    // the shutdown is handled.
+    Logging::ERROR("Invalid kafka configuration:\n" + errstr, name);
     kill(getpid(), SIGINT);
+    conf = RdKafka::Conf::create(RdKafka::Conf::CONF_GLOBAL);
   }
 
   /* Set the delivery report callback.
@@ -259,63 +500,251 @@ int main(int argc, char *argv[])
    * either by putting it on the heap or as in this case as a stack variable
    * that will NOT go out of scope for the duration of the Producer object.
    */
-  KafkaDeliveryReportCb ex_dr_cb;
+  std::map<std::string, std::string> producer_config = config.producer();
+
+  /* Budget of messages enqueued in librdkafka but not yet acknowledged, shared by all
+   * processors and producers. Processors block when it is exhausted, delivery reports
+   * free it up again. */
+  size_t max_in_flight_messages = 100000;
+  size_t max_in_flight_bytes = 256 * 1024 * 1024;
+  if (producer_config.find("max_in_flight_messages") != producer_config.end())
+  {
+    max_in_flight_messages = std::stoul(producer_config["max_in_flight_messages"]);
+  }
+  if (producer_config.find("max_in_flight_bytes") != producer_config.end())
+  {
+    max_in_flight_bytes = std::stoul(producer_config["max_in_flight_bytes"]);
+  }
+  InFlightBudget in_flight_budget(max_in_flight_bytes, max_in_flight_messages, sig_channel);
+
+  KafkaDeliveryReportCb ex_dr_cb(&in_flight_budget);
   if (conf->set("dr_cb", &ex_dr_cb, errstr) != RdKafka::Conf::CONF_OK)
   {
     Logging::ERROR(errstr, name);
     kill(getpid(), SIGINT);
   }
 
-  RdKafka::Producer *kafka_producer = RdKafka::Producer::create(conf, errstr);
-  if (!kafka_producer)
+  // Errors, logs and (with kafka.statistics.interval.ms) statistics of librdkafka
+  std::string kafka_batch_size;
+  conf->get("batch.size", kafka_batch_size);
+  KafkaEventCb ex_event_cb(kafka_batch_size.empty() ? 1000000 : std::stoul(kafka_batch_size));
+  if (conf->set("event_cb", &ex_event_cb, errstr) != RdKafka::Conf::CONF_OK)
   {
-    Logging::ERROR("Failed to create Kafka producer: " + errstr, name);
+    Logging::ERROR(errstr, name);
+    kill(getpid(), SIGINT);
+  }
+
+  // Per-file checkpoints of the acknowledged rows, see FileCheckpoint
+  bool checkpoints = !producer_config["checkpoint"].compare("true");
+  std::string idempotence;
+  if (checkpoints && kafka_sink && (conf->get("enable.idempotence", idempotence) != RdKafka::Conf::CONF_OK || idempotence.compare("true")))
+  {
+    Logging::WARN("Checkpoints without enable.idempotence may duplicate messages of retried batches", name);
+  }
+
+  size_t batch_size = 1000;
+  if (producer_config.find("batch_size") != producer_config.end())
+  {
+    batch_size = std::stoul(producer_config["batch_size"]);
+  }
+
+  unsigned int processor_thread_count = std::max<unsigned int>(1, std::thread::hardware_concurrency() - 5); // - main, LogProcessor, DirectoryPoller, KafkaPoller, Signal
+  if (!stream_path.empty())
+  {
+    // A stream is read by a single processor
+    processor_thread_count = 1;
+  }
+
+  /* Producer topology:
+   *  shared     - one producer used by all processor threads (default)
+   *  per_thread - one producer per processor thread
+   *  sharded    - 'count' producers, batches are sharded over them by (topic, partition).
+   *               Requires local_partitioner, without it the partition is only known to
+   *               librdkafka and all batches of a topic would go to one shard.
+   * Every producer gets its own KafkaPoller serving its delivery reports. */
+  std::string topology = producer_config.find("topology") != producer_config.end() ? producer_config["topology"] : "shared";
+  size_t producer_count = 1;
+  if (!topology.compare("per_thread"))
+  {
+    producer_count = processor_thread_count;
+  }
+  else if (!topology.compare("sharded"))
+  {
+    producer_count = producer_config.find("count") != producer_config.end() ? std::stoul(producer_config["count"]) : 0;
+    if (producer_count == 0)
+    {
+      Logging::ERROR("producer.count must be greater than 0 for the sharded topology", name);
+      kill(getpid(), SIGINT);
+      producer_count = 1;
+    }
+    if (producer_config["local_partitioner"].compare("true"))
+    {
+      Logging::ERROR("The sharded topology requires producer.local_partitioner: true", name);
+      kill(getpid(), SIGINT);
+    }
+  }
+  else if (topology.compare("shared"))
+  {
+    Logging::ERROR("Unknown producer topology '" + topology + "'", name);
     kill(getpid(), SIGINT);
   }
+  if (!kafka_sink)
+  {
+    producer_count = 0;
+  }
 
-  KafkaPoller kafka_poller(kafka_producer, sig_channel);
-  kafka_poller.start();
+  std::vector<RdKafka::Producer *> kafka_producers;
+  std::vector<std::unique_ptr<KafkaPoller>> kafka_pollers;
+  for (size_t i = 0; i < producer_count; ++i)
+  {
+    RdKafka::Producer *kafka_producer = RdKafka::Producer::create(conf, errstr);
+    if (!kafka_producer)
+    {
+      Logging::ERROR("Failed to create Kafka producer: " + errstr, name);
+      kill(getpid(), SIGINT);
+      break;
+    }
+    kafka_producers.push_back(kafka_producer);
+
+    kafka_pollers.emplace_back(std::make_unique<KafkaPoller>(kafka_producer, sig_channel));
+    kafka_pollers.back()->start();
+  }
+  if (kafka_sink)
+  {
+    Logging::INFO("Created " + std::to_string(kafka_producers.size()) + " Kafka producer(s) using the '" + topology + "' topology", name);
+  }
+
+  // Partition counts for the client-side partitioner
+  std::map<std::string, int32_t> partition_counts;
+  bool local_partitioner = !producer_config["local_partitioner"].compare("true");
+  if (local_partitioner && !kafka_producers.empty())
+  {
+    std::vector<std::string> topics;
+    for (const auto &[topic, schema_config] : schemas)
+    {
+      topics.emplace_back(topic);
+    }
+    partition_counts = KafkaPartitioner::partition_counts(kafka_producers.front(), topics, 10 * 1000);
+  }
+
+  std::unique_ptr<SinkFactory> sink_factory;
+  CountingSinkFactory *counting_sink_factory = nullptr;
+  if (kafka_sink)
+  {
+    sink_factory = std::make_unique<KafkaSinkFactory>(kafka_producers, !topology.compare("per_thread"), &in_flight_budget, local_partitioner ? &partition_counts : nullptr, batch_size);
+  }
+  else if (!sink_type.compare("null"))
+  {
+    sink_factory = std::make_unique<NullSinkFactory>();
+    Logging::INFO("Discarding all messages", name);
+  }
+  else if (!sink_type.compare("counting"))
+  {
+    counting_sink_factory = new CountingSinkFactory();
+    sink_factory.reset(counting_sink_factory);
+    Logging::INFO("Counting and discarding all messages", name);
+  }
+  else
+  {
+    std::string directory = sink_config["directory"];
+    struct stat info;
+    if (stat(directory.c_str(), &info) != 0 || !(info.st_mode & S_IFDIR))
+    {
+      Logging::ERROR("sink.directory '" + directory + "' is not a directory", name);
+      kill(getpid(), SIGINT);
+    }
+
+    OcfWriter::Codec codec = OcfWriter::Codec::DEFLATE;
+    try
+    {
+      codec = OcfWriter::codec(sink_config.find("codec") != sink_config.end() ? sink_config["codec"] : "deflate");
+    }
+    catch (const std::invalid_argument &e)
+    {
+      Logging::ERROR(e.what(), name);
+      kill(getpid(), SIGINT);
+    }
+
+    size_t block_size = sink_config.find("block_size") != sink_config.end() ? std::stoul(sink_config["block_size"]) : 1024 * 1024;
+    sink_factory = std::make_unique<OcfSinkFactory>(directory, &schemas, codec, block_size);
+    Logging::INFO("Writing Avro files to '" + directory + "'", name);
+  }
 
   /*************************************************************************
    *
    * DIRECTORY WATCHER
    *
    *************************************************************************/
-  DirectoryPoller poller = DirectoryPoller::builder("DirectoryPoller")
-                               .with_directory(dir_to_watch)
-                               .with_sig_channel(sig_channel)
-                               .build();
+  std::unique_ptr<AbstractPoller> poller;
+  if (!stream_path.empty())
+  {
+    poller = std::make_unique<StreamPoller>("StreamPoller", stream_path, sig_channel);
+  }
+#ifdef __linux__
+  else if (!socket_path.empty())
+  {
+    // Rows of the connections are cut into batches of batch_rows, or what arrived within max_delay_ms
+    std::map<std::string, std::string> socket_config = config.socket();
+    size_t batch_rows = socket_config.find("batch_rows") != socket_config.end() ? std::stoul(socket_config["batch_rows"]) : 1000;
+    int max_delay_ms = socket_config.find("max_delay_ms") != socket_config.end() ? std::stoi(socket_config["max_delay_ms"]) : 10;
+    size_t max_queued_batches = socket_config.find("max_queued_batches") != socket_config.end() ? std::stoul(socket_config["max_queued_batches"]) : 64;
+    poller = std::make_unique<SocketPoller>("SocketPoller", socket_path, batch_rows, max_delay_ms, max_queued_batches, sig_channel);
+  }
+#endif
+  else
+  {
+    auto builder = DirectoryPoller::builder("DirectoryPoller").with_sig_channel(sig_channel);
+    for (const DirectoryConfig &directory : directories)
+    {
+      builder.with_directory(directory);
+    }
+    poller = std::make_unique<DirectoryPoller>(builder.build());
+  }
+
+  // Streams are flushed (and thereby checkpointed) every flush_rows rows or flush_interval_ms
+  std::map<std::string, std::string> stream_config = config.stream();
+  size_t stream_flush_rows = stream_config.find("flush_rows") != stream_config.end() ? std::stoul(stream_config["flush_rows"]) : 10000;
+  int stream_flush_interval_ms = stream_config.find("flush_interval_ms") != stream_config.end() ? std::stoi(stream_config["flush_interval_ms"]) : 1000;
+
+  // Socket batches as well, a connection whose rows were not delivered is closed
+  std::map<std::string, std::string> socket_config = config.socket();
+  size_t socket_flush_rows = socket_config.find("flush_rows") != socket_config.end() ? std::stoul(socket_config["flush_rows"]) : 10000;
+  int socket_flush_interval_ms = socket_config.find("flush_interval_ms") != socket_config.end() ? std::stoi(socket_config["flush_interval_ms"]) : 1000;
 
   /*************************************************************************
    *
    * FILE PROCESSORS
    *
    *************************************************************************/
-  unsigned int processor_thread_count = std::max<unsigned int>(1, std::thread::hardware_concurrency() - 5); // - main, LogProcessor, DirectoryPoller, KafkaPoller, Signal
-
-  std::vector<std::unique_ptr<AbstractTransformer>> transformers = config.transformers();
-  std::vector<ProcessorBridge> processors;
-
-  std::pair<std::string, int> ma;
-  if (config.has_key("max_age"))
+  // One JSON line per processed file
+  std::unique_ptr<FileReportWriter> report_writer;
+  if (!config.report_file().empty())
   {
-    ma = config.max_age();
+    report_writer = std::make_unique<FileReportWriter>(config.report_file());
+    if (!report_writer->is_open())
+    {
+      kill(getpid(), SIGINT);
+    }
   }
 
+  std::vector<ProcessorBridge> processors;
+
   for (size_t i = 1; i <= processor_thread_count; ++i)
   {
     auto builder = CsvProcessor::builder("CsvProcessor " + std::to_string(i))
-                       .with_active_processors_counter(&active_processors)
-                       .with_logging_cv(&log_cv)
-                       .with_logging_mutex(&log_cv_mutex)
-                       .with_transformers(&transformers)
-                       .with_kafka_producer(kafka_producer)
-                       .with_schemas(&schemas)
+                       .with_profiles(&profiles)
+                       .with_sink_factory(sink_factory.get())
+                       .with_checkpoints(checkpoints)
+                       .with_report_writer(report_writer.get())
                        .with_sig_channel(sig_channel);
 
-    if (config.has_key("max_age"))
+    if (!stream_path.empty())
     {
-      builder.with_drop_max_age(&ma);
+      builder.with_streaming(stream_flush_rows, stream_flush_interval_ms);
+    }
+    else if (!socket_path.empty())
+    {
+      builder.with_batch_flush(socket_flush_rows, socket_flush_interval_ms);
     }
 
     std::unique_ptr<AbstractProcessor> ptr = builder.build();
@@ -328,20 +757,71 @@ int main(int argc, char *argv[])
    * START MAIN LOOP
    *
    *************************************************************************/
-  Connector connector(poller, processors);
+  Connector connector(*poller, processors);
+  auto started = std::chrono::steady_clock::now();
   connector.start();
+  double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
 
   /*************************************************************************
    *
    * SHUTDOWN
    *
    *************************************************************************/
-  kafka_poller.join();
+  for (const auto &kafka_poller : kafka_pollers)
+  {
+    kafka_poller->join();
+  }
+
+  if (in_flight_budget.blocked_count() > 0)
+  {
+    Logging::INFO("Processors were blocked by the in-flight budget " + std::to_string(in_flight_budget.blocked_count()) + " times for " + std::to_string(in_flight_budget.blocked_ms()) + "ms in total", name);
+  }
+
+  if (counting_sink_factory)
+  {
+    for (const auto &[topic, counts] : counting_sink_factory->totals())
+    {
+      Logging::INFO("Topic '" + topic + "': " + std::to_string(counts.messages) + " messages, " + std::to_string(counts.bytes) + " bytes, " + std::to_string(static_cast<size_t>(counts.messages / elapsed_s)) + " messages/s", name);
+    }
+  }
+
+  // The processors add the dropped rows to the metrics once per file, per filter name
+  std::set<std::string> filter_names;
+  for (const auto &[profile_name, profile] : profiles)
+  {
+    for (const auto &filter : profile.filters)
+    {
+      filter_names.insert(filter->name());
+    }
+  }
+  for (const std::string &filter_name : filter_names)
+  {
+    uint64_t dropped = Metrics::Registry::instance().counter("flycatcher_rows_filtered_total", "CSV rows dropped by filters", Metrics::label("filter", filter_name)).value();
+    Logging::INFO("Filter '" + filter_name + "' dropped " + std::to_string(dropped) + " events in total", name);
+  }
+
+  if (schema_cache)
+  {
+    schema_cache->join();
+  }
+
+  if (metrics_exporter)
+  {
+    metrics_exporter->join();
+  }
+
+  if (dump_trace_on_exit)
+  {
+    dump_trace();
+  }
 
   log_processor.stop();
   log_processor.join();
 
   delete conf;
-  delete kafka_producer;
+  for (RdKafka::Producer *kafka_producer : kafka_producers)
+  {
+    delete kafka_producer;
+  }
   return 0;
 }
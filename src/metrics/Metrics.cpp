@@ -0,0 +1,224 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+
+static std::atomic<size_t> next_shard = 0;
+
+size_t Metrics::shard()
+{
+    thread_local size_t index = next_shard.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+    return index;
+}
+
+uint64_t Metrics::Counter::value() const
+{
+    uint64_t total = 0;
+    for (const Cell &cell : m_cells)
+    {
+        total += cell.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+Metrics::Histogram::Histogram(std::vector<double> bounds) : m_bounds(std::move(bounds)), m_shard_lines(m_bounds.size() / COUNTS_PER_LINE + 1), m_lines(std::make_unique<CountLine[]>(SHARDS * m_shard_lines))
+{
+}
+
+std::atomic<uint64_t> &Metrics::Histogram::count(size_t shard, size_t bucket) const
+{
+    return m_lines[shard * m_shard_lines + bucket / COUNTS_PER_LINE].counts[bucket % COUNTS_PER_LINE];
+}
+
+void Metrics::Histogram::observe(double value)
+{
+    size_t bucket = std::lower_bound(m_bounds.begin(), m_bounds.end(), value) - m_bounds.begin();
+    size_t s = shard();
+    count(s, bucket).fetch_add(1, std::memory_order_relaxed);
+    m_sums[s].value.fetch_add(value, std::memory_order_relaxed);
+}
+
+const std::vector<double> &Metrics::Histogram::bounds() const
+{
+    return m_bounds;
+}
+
+std::vector<uint64_t> Metrics::Histogram::cumulative_counts() const
+{
+    std::vector<uint64_t> counts(m_bounds.size() + 1, 0);
+    for (size_t s = 0; s < SHARDS; ++s)
+    {
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            counts[i] += count(s, i).load(std::memory_order_relaxed);
+        }
+    }
+    for (size_t i = 1; i < counts.size(); ++i)
+    {
+        counts[i] += counts[i - 1];
+    }
+    return counts;
+}
+
+double Metrics::Histogram::sum() const
+{
+    double total = 0;
+    for (const Sum &s : m_sums)
+    {
+        total += s.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::vector<double> Metrics::exponential_buckets(double start, double factor, size_t count)
+{
+    std::vector<double> bounds;
+    for (size_t i = 0; i < count; ++i, start *= factor)
+    {
+        bounds.push_back(start);
+    }
+    return bounds;
+}
+
+std::string Metrics::label(const std::string &key, const std::string &value)
+{
+    std::string result = key + "=\"";
+    for (char c : value)
+    {
+        if (c == '\\' || c == '"')
+        {
+            result += '\\';
+            result += c;
+        }
+        else if (c == '\n')
+        {
+            result += "\\n";
+        }
+        else
+        {
+            result += c;
+        }
+    }
+    return result + "\"";
+}
+
+Metrics::Registry &Metrics::Registry::instance()
+{
+    static Registry i;
+    return i;
+}
+
+Metrics::Registry::Family &Metrics::Registry::family(const std::string &name, const std::string &help, const std::string &type)
+{
+    Family &f = m_families[name];
+    if (f.type.empty())
+    {
+        f.help = help;
+        f.type = type;
+    }
+    return f;
+}
+
+Metrics::Counter &Metrics::Registry::counter(const std::string &name, const std::string &help, const std::string &labels)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto &counter = family(name, help, "counter").counters[labels];
+    if (!counter)
+    {
+        counter = std::make_unique<Counter>();
+    }
+    return *counter;
+}
+
+Metrics::Gauge &Metrics::Registry::gauge(const std::string &name, const std::string &help, const std::string &labels)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto &gauge = family(name, help, "gauge").gauges[labels];
+    if (!gauge)
+    {
+        gauge = std::make_unique<Gauge>();
+    }
+    return *gauge;
+}
+
+void Metrics::Registry::gauge(const std::string &name, const std::string &help, std::function<double()> callback, const std::string &labels)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    family(name, help, "gauge").callbacks[labels] = std::move(callback);
+}
+
+Metrics::Histogram &Metrics::Registry::histogram(const std::string &name, const std::string &help, std::vector<double> bounds, const std::string &labels)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto &histogram = family(name, help, "histogram").histograms[labels];
+    if (!histogram)
+    {
+        histogram = std::make_unique<Histogram>(std::move(bounds));
+    }
+    return *histogram;
+}
+
+static std::string format_value(double value)
+{
+    if (std::isnan(value))
+    {
+        return "NaN";
+    }
+    if (std::isinf(value))
+    {
+        return value > 0 ? "+Inf" : "-Inf";
+    }
+
+    // Shortest representation that round-trips
+    char buffer[32];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    return std::string(buffer, end);
+}
+
+static std::string series(const std::string &name, const std::string &labels, const std::string &extra_label = "")
+{
+    std::string all = labels;
+    if (!extra_label.empty())
+    {
+        all += (all.empty() ? "" : ",") + extra_label;
+    }
+    return all.empty() ? name : name + "{" + all + "}";
+}
+
+std::string Metrics::Registry::render()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::string out;
+    for (const auto &[name, f] : m_families)
+    {
+        out += "# HELP " + name + " " + f.help + "\n";
+        out += "# TYPE " + name + " " + f.type + "\n";
+
+        for (const auto &[labels, counter] : f.counters)
+        {
+            out += series(name, labels) + " " + std::to_string(counter->value()) + "\n";
+        }
+        for (const auto &[labels, gauge] : f.gauges)
+        {
+            out += series(name, labels) + " " + format_value(gauge->value()) + "\n";
+        }
+        for (const auto &[labels, callback] : f.callbacks)
+        {
+            out += series(name, labels) + " " + format_value(callback()) + "\n";
+        }
+        for (const auto &[labels, histogram] : f.histograms)
+        {
+            std::vector<uint64_t> counts = histogram->cumulative_counts();
+            const std::vector<double> &bounds = histogram->bounds();
+            for (size_t i = 0; i < bounds.size(); ++i)
+            {
+                out += series(name + "_bucket", labels, "le=\"" + format_value(bounds[i]) + "\"") + " " + std::to_string(counts[i]) + "\n";
+            }
+            out += series(name + "_bucket", labels, "le=\"+Inf\"") + " " + std::to_string(counts.back()) + "\n";
+            out += series(name + "_sum", labels) + " " + format_value(histogram->sum()) + "\n";
+            out += series(name + "_count", labels) + " " + std::to_string(counts.back()) + "\n";
+        }
+    }
+    return out;
+}
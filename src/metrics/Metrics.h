@@ -0,0 +1,160 @@
+/**
+ * Process-wide metrics in the Prometheus data model.
+ *
+ * Counters and histograms are sharded: every thread updates its own cache line with a relaxed
+ * atomic add, so updates don't contend and are cheap enough for per-row use. The shards are
+ * only summed up when the metrics are rendered. Metrics are registered once (e.g. into a
+ * static reference) and then used without any lookup or lock.
+ **/
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Metrics
+{
+    static constexpr size_t SHARDS = 16;
+
+    /**
+     * Shard of the calling thread. Threads are spread round robin over the shards.
+     **/
+    size_t shard();
+
+    class Counter
+    {
+    private:
+        struct alignas(64) Cell
+        {
+            std::atomic<uint64_t> value = 0;
+        };
+        Cell m_cells[SHARDS];
+
+    public:
+        void inc(uint64_t n = 1)
+        {
+            m_cells[shard()].value.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        uint64_t value() const;
+    };
+
+    class Gauge
+    {
+    private:
+        std::atomic<double> m_value = 0;
+
+    public:
+        void set(double value)
+        {
+            m_value.store(value, std::memory_order_relaxed);
+        }
+
+        double value() const
+        {
+            return m_value.load(std::memory_order_relaxed);
+        }
+    };
+
+    /**
+     * Distribution of observed values over fixed buckets (upper bounds, ascending).
+     **/
+    class Histogram
+    {
+    private:
+        static constexpr size_t COUNTS_PER_LINE = 8;
+
+        struct alignas(64) CountLine
+        {
+            std::atomic<uint64_t> counts[COUNTS_PER_LINE];
+        };
+        struct alignas(64) Sum
+        {
+            std::atomic<double> value = 0;
+        };
+        const std::vector<double> m_bounds;
+        // Lines per shard for one count per bound plus +Inf
+        const size_t m_shard_lines;
+        // The counts of all shards in one allocation, every shard starting on a line of its own
+        std::unique_ptr<CountLine[]> m_lines;
+        Sum m_sums[SHARDS];
+
+        std::atomic<uint64_t> &count(size_t shard, size_t bucket) const;
+
+    public:
+        Histogram(std::vector<double> bounds);
+
+        void observe(double value);
+
+        const std::vector<double> &bounds() const;
+
+        /**
+         * Cumulative counts per bound, the last one being the total count.
+         **/
+        std::vector<uint64_t> cumulative_counts() const;
+        double sum() const;
+    };
+
+    /**
+     * Bucket bounds start, start * factor, ... (count bounds)
+     **/
+    std::vector<double> exponential_buckets(double start, double factor, size_t count);
+
+    /**
+     * Label pair key="value" with the value escaped for the text format.
+     **/
+    std::string label(const std::string &key, const std::string &value);
+
+    class Registry
+    {
+    private:
+        struct Family
+        {
+            std::string help;
+            std::string type;
+            std::map<std::string, std::unique_ptr<Counter>> counters;
+            std::map<std::string, std::unique_ptr<Gauge>> gauges;
+            std::map<std::string, std::function<double()>> callbacks;
+            std::map<std::string, std::unique_ptr<Histogram>> histograms;
+        };
+
+        std::mutex m_mutex;
+        std::map<std::string, Family> m_families;
+
+        Registry() = default;
+        Family &family(const std::string &name, const std::string &help, const std::string &type);
+
+    public:
+        Registry(const Registry &) = delete;
+        void operator=(const Registry &) = delete;
+
+        static Registry &instance();
+
+        /*
+        Metrics are identified by name and labels, e.g. topic="spo". Registering the same
+        metric again returns the existing one.
+        */
+        Counter &counter(const std::string &name, const std::string &help, const std::string &labels = "");
+        Gauge &gauge(const std::string &name, const std::string &help, const std::string &labels = "");
+        Histogram &histogram(const std::string &name, const std::string &help, std::vector<double> bounds, const std::string &labels = "");
+
+        /**
+         * Gauge evaluated when the metrics are rendered. The callback must stay valid until
+         * the exporter is stopped.
+         **/
+        void gauge(const std::string &name, const std::string &help, std::function<double()> callback, const std::string &labels = "");
+
+        /**
+         * All metrics in the Prometheus text exposition format.
+         **/
+        std::string render();
+    };
+} // end namespace
+
+#endif
@@ -0,0 +1,184 @@
+#include "MetricsExporter.h"
+#include "Metrics.h"
+#include "ThreadGuard.h"
+#include "logging/Logging.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+// macOS: a scraper closing early must not raise SIGPIPE
+#define MSG_NOSIGNAL 0
+#endif
+
+static std::string name = "MetricsExporter";
+
+MetricsExporter::MetricsExporter(std::string address, std::shared_ptr<SignalChannel> sig_channel) : m_address(address), m_sig_channel(sig_channel)
+{
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    if (m_fd >= 0)
+    {
+        close(m_fd);
+    }
+}
+
+bool MetricsExporter::start()
+{
+    if (!listen())
+    {
+        return false;
+    }
+    m_t = std::make_unique<std::thread>(&MetricsExporter::run, this);
+    Logging::INFO("Serving metrics on '" + m_address + "'", name);
+    return true;
+}
+
+void MetricsExporter::join() const
+{
+    if (m_t)
+    {
+        ThreadGuard g(*m_t);
+    }
+}
+
+bool MetricsExporter::listen()
+{
+    sockaddr_storage addr{};
+    socklen_t addr_len;
+
+    if (!m_address.empty() && m_address[0] == '/')
+    {
+        sockaddr_un *un = reinterpret_cast<sockaddr_un *>(&addr);
+        if (m_address.size() >= sizeof(un->sun_path))
+        {
+            Logging::ERROR("Socket path '" + m_address + "' is too long", name);
+            return false;
+        }
+        un->sun_family = AF_UNIX;
+        strncpy(un->sun_path, m_address.c_str(), sizeof(un->sun_path) - 1);
+        addr_len = sizeof(sockaddr_un);
+
+        // Left behind by a previous run
+        unlink(m_address.c_str());
+    }
+    else
+    {
+        size_t colon = m_address.rfind(':');
+        std::string host = colon == std::string::npos ? "127.0.0.1" : m_address.substr(0, colon);
+        std::string port = colon == std::string::npos ? m_address : m_address.substr(colon + 1);
+
+        sockaddr_in *in = reinterpret_cast<sockaddr_in *>(&addr);
+        in->sin_family = AF_INET;
+        try
+        {
+            in->sin_port = htons(static_cast<uint16_t>(std::stoul(port)));
+        }
+        catch (const std::exception &)
+        {
+            Logging::ERROR("Invalid metrics address '" + m_address + "'", name);
+            return false;
+        }
+        if (inet_pton(AF_INET, host.c_str(), &in->sin_addr) != 1)
+        {
+            Logging::ERROR("Invalid metrics address '" + m_address + "'", name);
+            return false;
+        }
+        addr_len = sizeof(sockaddr_in);
+    }
+
+    m_fd = socket(addr.ss_family, SOCK_STREAM, 0);
+    if (m_fd < 0)
+    {
+        Logging::ERROR("Unable to create socket: " + std::string(strerror(errno)), name);
+        return false;
+    }
+
+    int on = 1;
+    setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    if (bind(m_fd, reinterpret_cast<sockaddr *>(&addr), addr_len) != 0 || ::listen(m_fd, 16) != 0)
+    {
+        Logging::ERROR("Unable to listen on '" + m_address + "': " + strerror(errno), name);
+        close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+void MetricsExporter::run()
+{
+    pollfd pfd{m_fd, POLLIN, 0};
+    while (!m_sig_channel->m_shutdown_requested.load())
+    {
+        // Wake up regularly to notice a shutdown
+        if (poll(&pfd, 1, 200) <= 0)
+        {
+            continue;
+        }
+
+        int client = accept(m_fd, nullptr, nullptr);
+        if (client < 0)
+        {
+            continue;
+        }
+        serve(client);
+        close(client);
+    }
+
+    close(m_fd);
+    m_fd = -1;
+    if (!m_address.empty() && m_address[0] == '/')
+    {
+        unlink(m_address.c_str());
+    }
+    Logging::INFO("Shutting down", name);
+}
+
+void MetricsExporter::serve(int client)
+{
+    // Read (and ignore) the request up to the end of its header
+    timeval timeout{1, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.find("\n\n") == std::string::npos && request.size() < 8192)
+    {
+        ssize_t n = recv(client, buffer, sizeof(buffer), 0);
+        if (n <= 0)
+        {
+            break;
+        }
+        request.append(buffer, n);
+    }
+
+    std::string body = Metrics::Registry::instance().render();
+    std::string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n";
+    response += "Content-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+    response += body;
+
+    size_t sent = 0;
+    while (sent < response.size())
+    {
+        ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+        {
+            LOG_DEBUG("Unable to send metrics: " + std::string(strerror(errno)), name);
+            return;
+        }
+        sent += n;
+    }
+}
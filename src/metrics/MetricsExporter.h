@@ -0,0 +1,41 @@
+/**
+ * Serves the metrics of the Metrics::Registry in the Prometheus text format over HTTP.
+ *
+ * The address is either <host>:<port>, a bare <port> (bound to 127.0.0.1) or the path of a
+ * Unix domain socket (starting with '/'). Every request is answered with the metrics,
+ * whatever its path. The exporter stops once a shutdown is requested on the signal channel.
+ **/
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+
+#include "SignalChannel.h"
+#include <memory>
+#include <string>
+#include <thread>
+
+class MetricsExporter
+{
+private:
+    const std::string m_address;
+    std::shared_ptr<SignalChannel> m_sig_channel;
+    std::unique_ptr<std::thread> m_t;
+    int m_fd = -1;
+
+    bool listen();
+    void run();
+    void serve(int client);
+
+public:
+    MetricsExporter(std::string address, std::shared_ptr<SignalChannel> sig_channel);
+    MetricsExporter(const MetricsExporter &) = delete;
+    void operator=(const MetricsExporter &) = delete;
+    ~MetricsExporter();
+
+    /**
+     * Bind the address and start serving. Returns false if the address can't be bound.
+     **/
+    bool start();
+    void join() const;
+};
+
+#endif
@@ -0,0 +1,34 @@
+#include "Route.h"
+#include <fnmatch.h>
+
+Route::Route(std::string pattern, bool regex, std::map<std::string, SchemaConfig> schemas, std::optional<std::vector<std::unique_ptr<AbstractTransformer>>> transformers) : m_pattern(pattern), m_schemas(std::move(schemas)), m_transformers(std::move(transformers))
+{
+    if (regex)
+    {
+        m_regex.emplace(m_pattern, std::regex::ECMAScript | std::regex::optimize);
+    }
+}
+
+bool Route::matches(const std::string &file_name) const
+{
+    if (m_regex)
+    {
+        return std::regex_match(file_name, *m_regex);
+    }
+    return fnmatch(m_pattern.c_str(), file_name.c_str(), 0) == 0;
+}
+
+const std::string &Route::pattern() const
+{
+    return m_pattern;
+}
+
+const std::map<std::string, SchemaConfig> &Route::schemas() const
+{
+    return m_schemas;
+}
+
+std::vector<std::unique_ptr<AbstractTransformer>> *Route::transformers()
+{
+    return m_transformers ? &*m_transformers : nullptr;
+}
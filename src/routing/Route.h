@@ -0,0 +1,55 @@
+/**
+ * An entry of the 'routes' section. Files whose name matches the glob or regular expression
+ * are published to a subset of the topics of their profile, optionally with their own chain
+ * of transformers.
+ *
+ * Resolved once per file, so the rows of a file are only serialized for the topics that apply to it.
+ **/
+#ifndef ROUTE_H
+#define ROUTE_H
+
+#include "config/SchemaConfig.h"
+#include "transformers/AbstractTransformer.h"
+#include <map>
+#include <memory>
+#include <optional>
+#include <regex>
+#include <string>
+#include <vector>
+
+class Route
+{
+private:
+    const std::string m_pattern;
+    // Glob (fnmatch(3)) if not set
+    std::optional<std::regex> m_regex;
+    std::map<std::string, SchemaConfig> m_schemas;
+    std::optional<std::vector<std::unique_ptr<AbstractTransformer>>> m_transformers;
+
+public:
+    /**
+     * Throws std::regex_error if regex is set and the pattern is not a valid ECMAScript expression.
+     **/
+    Route(std::string pattern, bool regex, std::map<std::string, SchemaConfig> schemas, std::optional<std::vector<std::unique_ptr<AbstractTransformer>>> transformers);
+    Route(const Route &) = delete;
+    void operator=(const Route &) = delete;
+    Route(Route &&) = default;
+
+    /**
+     * Returns true if the file name (without directory) matches the pattern.
+     **/
+    bool matches(const std::string &file_name) const;
+    const std::string &pattern() const;
+
+    /**
+     * Topics of the route, empty for all topics of the profile.
+     **/
+    const std::map<std::string, SchemaConfig> &schemas() const;
+
+    /**
+     * Transformers of the route, nullptr for the transformers of the profile.
+     **/
+    std::vector<std::unique_ptr<AbstractTransformer>> *transformers();
+};
+
+#endif
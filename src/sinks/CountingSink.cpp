@@ -0,0 +1,63 @@
+#include "CountingSink.h"
+
+CountingSink::CountingSink(CountingSinkFactory *factory) : m_factory(factory)
+{
+}
+
+CountingSink::~CountingSink()
+{
+    flush();
+}
+
+void CountingSink::produce(const std::string &topic, std::string_view key, std::vector<char> &&payload, CheckpointSegment *segment)
+{
+    SinkCounts &counts = m_counts[topic];
+    ++counts.messages;
+    counts.bytes += key.size() + payload.size();
+
+    if (segment)
+    {
+        segment->ack(true);
+    }
+}
+
+void CountingSink::flush()
+{
+    if (!m_counts.empty())
+    {
+        m_factory->add(m_counts);
+        m_counts.clear();
+    }
+}
+
+size_t CountingSink::outstanding() const
+{
+    return 0;
+}
+
+size_t CountingSink::take_failed()
+{
+    return 0;
+}
+
+Sink *CountingSinkFactory::create(const std::string &)
+{
+    return new CountingSink(this);
+}
+
+void CountingSinkFactory::add(const std::map<std::string, SinkCounts> &counts)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &[topic, c] : counts)
+    {
+        SinkCounts &total = m_totals[topic];
+        total.messages += c.messages;
+        total.bytes += c.bytes;
+    }
+}
+
+std::map<std::string, SinkCounts> CountingSinkFactory::totals()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_totals;
+}
@@ -0,0 +1,56 @@
+/**
+ * Sink discarding every message like NullSink, but counting the messages and their bytes
+ * per topic. The counts of a sink are added to its factory's totals on every flush(), i.e.
+ * once per input file, so that the hot path doesn't touch shared state.
+ **/
+#ifndef COUNTING_SINK_H
+#define COUNTING_SINK_H
+
+#include "Sink.h"
+#include <map>
+#include <mutex>
+
+struct SinkCounts
+{
+    size_t messages = 0;
+    size_t bytes = 0;
+};
+
+class CountingSinkFactory;
+
+class CountingSink : public Sink
+{
+private:
+    CountingSinkFactory *m_factory;
+    std::map<std::string, SinkCounts> m_counts;
+
+public:
+    CountingSink(CountingSinkFactory *factory);
+    CountingSink(const CountingSink &) = delete;
+    void operator=(const CountingSink &) = delete;
+    ~CountingSink() override;
+
+    void produce(const std::string &topic, std::string_view key, std::vector<char> &&payload, CheckpointSegment *segment) override;
+    void flush() override;
+    size_t outstanding() const override;
+    size_t take_failed() override;
+};
+
+class CountingSinkFactory : public SinkFactory
+{
+private:
+    std::mutex m_mutex;
+    std::map<std::string, SinkCounts> m_totals;
+
+public:
+    Sink *create(const std::string &processor_name) override;
+
+    void add(const std::map<std::string, SinkCounts> &counts);
+
+    /**
+     * Totals per topic over all sinks, as of their last flush().
+     **/
+    std::map<std::string, SinkCounts> totals();
+};
+
+#endif
@@ -0,0 +1,251 @@
+#include "KafkaSink.h"
+#include "logging/Logging.h"
+#include "impl/KafkaPartitioner.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <librdkafka/rdkafka.h> // for rd_kafka_produce_batch()
+
+KafkaSink::KafkaSink(std::string name, std::vector<RdKafka::Producer *> kafka_producers, InFlightBudget *in_flight_budget, const std::map<std::string, int32_t> *partition_counts, size_t batch_size) : m_name(name), m_kafka_producers(kafka_producers), m_in_flight_budget(in_flight_budget), m_partition_counts(partition_counts), m_batch_size(batch_size), m_used(kafka_producers.size(), false)
+{
+}
+
+KafkaSink::~KafkaSink()
+{
+    for (auto &[key, topic] : m_topics)
+    {
+        delete topic;
+    }
+}
+
+void KafkaSink::produce(const std::string &topic, std::string_view key, std::vector<char> &&payload, CheckpointSegment *segment)
+{
+    int32_t partition = RdKafka::Topic::PARTITION_UA;
+    if (m_partition_counts)
+    {
+        auto partition_cnt_it = m_partition_counts->find(topic);
+        if (partition_cnt_it != m_partition_counts->end())
+        {
+            partition = KafkaPartitioner::partition(key, partition_cnt_it->second);
+        }
+    }
+
+    auto batch_it = m_batches.find(std::make_pair(std::string_view(topic), partition));
+    if (batch_it == m_batches.end())
+    {
+        batch_it = m_batches.emplace(std::make_pair(topic, partition), std::vector<PendingMessage>()).first;
+    }
+    batch_it->second.push_back(PendingMessage{std::string(key), std::move(payload), segment});
+    m_counts->in_flight.fetch_add(1);
+    if (++m_batched >= m_batch_size)
+    {
+        produce_batches();
+    }
+}
+
+size_t KafkaSink::producer_index(const std::string &topic_name, int32_t partition) const
+{
+    if (m_kafka_producers.size() == 1)
+    {
+        return 0;
+    }
+
+    size_t h = std::hash<std::string>{}(topic_name);
+    return (h + static_cast<size_t>(std::max<int32_t>(partition, 0))) % m_kafka_producers.size();
+}
+
+RdKafka::Topic *KafkaSink::topic_handle(size_t producer_idx, const std::string &topic_name)
+{
+    auto key = std::make_pair(producer_idx, topic_name);
+    auto it = m_topics.find(key);
+    if (it != m_topics.end())
+    {
+        return it->second;
+    }
+
+    std::string errstr;
+    RdKafka::Topic *topic = RdKafka::Topic::create(m_kafka_producers[producer_idx], topic_name, nullptr, errstr);
+    if (!topic)
+    {
+        throw std::runtime_error("Failed to create topic handle for '" + topic_name + "': " + errstr);
+    }
+    m_topics.emplace(key, topic);
+    return topic;
+}
+
+void KafkaSink::produce_batches()
+{
+    std::vector<rd_kafka_message_t> rkmessages;
+    for (auto &[destination, messages] : m_batches)
+    {
+        if (messages.empty())
+        {
+            continue;
+        }
+
+        const auto &[topic_name, partition] = destination;
+        size_t producer_idx = producer_index(topic_name, partition);
+        RdKafka::Topic *topic = nullptr;
+        try
+        {
+            topic = topic_handle(producer_idx, topic_name);
+        }
+        catch (const std::exception &e)
+        {
+            // The messages were handed over by earlier produce() calls, so they are failed here
+            Logging::ERROR(std::string(e.what()) + ". Dropping " + std::to_string(messages.size()) + " message(s)", m_name);
+            for (PendingMessage &message : messages)
+            {
+                if (message.segment)
+                {
+                    message.segment->ack(false);
+                }
+            }
+            m_counts->failed.fetch_add(messages.size());
+            m_counts->in_flight.fetch_sub(messages.size());
+            messages.clear();
+            continue;
+        }
+
+        m_used[producer_idx] = true;
+        size_t batch_bytes = 0;
+        rkmessages.assign(messages.size(), rd_kafka_message_t{});
+        for (size_t i = 0; i < messages.size(); ++i)
+        {
+            rkmessages[i].payload = messages[i].payload.data();
+            rkmessages[i].len = messages[i].payload.size();
+            rkmessages[i].key = messages[i].key.data();
+            rkmessages[i].key_len = messages[i].key.size();
+            rkmessages[i]._private = new KafkaDelivery{m_counts, messages[i].segment};
+            batch_bytes += rkmessages[i].len + rkmessages[i].key_len;
+        }
+
+        // Blocks while too much is in flight. Released by the delivery report callback.
+        if (m_in_flight_budget)
+        {
+            m_in_flight_budget->acquire(batch_bytes, messages.size());
+        }
+
+        /*
+        Enqueue the whole per-partition batch with a single call. librdkafka takes the partition
+        queue lock once per batch instead of once per message. With PARTITION_UA the configured
+        partitioner is run for each message.
+        */
+        while (!rkmessages.empty())
+        {
+            int enqueued = rd_kafka_produce_batch(topic->c_ptr(), partition, RD_KAFKA_MSG_F_COPY, rkmessages.data(), static_cast<int>(rkmessages.size()));
+            if (enqueued == static_cast<int>(rkmessages.size()))
+            {
+                break;
+            }
+
+            // Keep the messages that failed with a full queue for the next attempt, drop the rest
+            rd_kafka_resp_err_t last_err = RD_KAFKA_RESP_ERR_NO_ERROR;
+            size_t dropped = 0;
+            size_t dropped_bytes = 0;
+            auto retry_end = std::remove_if(rkmessages.begin(), rkmessages.end(), [&last_err, &dropped, &dropped_bytes](const rd_kafka_message_t &rkmessage)
+                                            {
+                                                if (rkmessage.err == RD_KAFKA_RESP_ERR_NO_ERROR)
+                                                {
+                                                    return true;
+                                                }
+                                                if (rkmessage.err != RD_KAFKA_RESP_ERR__QUEUE_FULL)
+                                                {
+                                                    last_err = rkmessage.err;
+                                                    ++dropped;
+                                                    dropped_bytes += rkmessage.len + rkmessage.key_len;
+
+                                                    // No delivery report will be served for this one
+                                                    KafkaDelivery *delivery = static_cast<KafkaDelivery *>(rkmessage._private);
+                                                    if (delivery->segment)
+                                                    {
+                                                        delivery->segment->ack(false);
+                                                    }
+                                                    delivery->counts->failed.fetch_add(1);
+                                                    delivery->counts->in_flight.fetch_sub(1);
+                                                    delete delivery;
+                                                    return true;
+                                                }
+                                                return false; });
+            rkmessages.erase(retry_end, rkmessages.end());
+            for (auto &rkmessage : rkmessages)
+            {
+                rkmessage.err = RD_KAFKA_RESP_ERR_NO_ERROR;
+            }
+
+            if (dropped > 0)
+            {
+                // No delivery report will be served for these
+                if (m_in_flight_budget)
+                {
+                    m_in_flight_budget->release(dropped_bytes, dropped);
+                }
+                Logging::ERROR("Failed to produce " + std::to_string(dropped) + " message(s) to topic '" + topic_name + "': " + rd_kafka_err2str(last_err), m_name);
+            }
+
+            if (!rkmessages.empty())
+            {
+                LOG_DEBUG("Queue full for topic '" + topic_name + "', retrying " + std::to_string(rkmessages.size()) + " message(s)", m_name);
+
+                /* The in-flight budget normally keeps the internal queue below its
+                * limits (queue.buffering.max.messages and queue.buffering.max.kbytes).
+                * If the budget is configured above them, wait for some delivery
+                * reports and retry. */
+                m_kafka_producers[producer_idx]->poll(100 /*block for max 100ms*/);
+            }
+        }
+
+        LOG_DEBUG("Enqueued " + std::to_string(messages.size()) + " message(s) for topic '" + topic_name + "' [" + std::to_string(partition) + "]", m_name);
+
+        // Payloads were copied by librdkafka. Keep the vector's capacity for the next batch.
+        messages.clear();
+    }
+    m_batched = 0;
+}
+
+void KafkaSink::flush()
+{
+    // Enqueue what is left of the last batch
+    produce_batches();
+
+    /* Wait for final messages to be delivered or fail, for max 10 seconds.
+     * Producer::flush() would also wait for the messages of the other sinks
+     * sharing the producers, so serve the delivery reports of the producers
+     * we used until our own messages are done. */
+    LOG_DEBUG("Flushing final messages...", m_name);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (m_counts->in_flight.load() > 0 && std::chrono::steady_clock::now() < deadline)
+    {
+        for (size_t i = 0; i < m_kafka_producers.size(); ++i)
+        {
+            if (m_used[i])
+            {
+                m_kafka_producers[i]->poll(10);
+            }
+        }
+    }
+}
+
+size_t KafkaSink::outstanding() const
+{
+    return m_counts->in_flight.load();
+}
+
+size_t KafkaSink::take_failed()
+{
+    return m_counts->failed.exchange(0);
+}
+
+KafkaSinkFactory::KafkaSinkFactory(std::vector<RdKafka::Producer *> kafka_producers, bool per_sink, InFlightBudget *in_flight_budget, const std::map<std::string, int32_t> *partition_counts, size_t batch_size) : m_kafka_producers(kafka_producers), m_per_sink(per_sink), m_in_flight_budget(in_flight_budget), m_partition_counts(partition_counts), m_batch_size(batch_size)
+{
+}
+
+Sink *KafkaSinkFactory::create(const std::string &processor_name)
+{
+    std::vector<RdKafka::Producer *> producers = m_kafka_producers;
+    if (m_per_sink)
+    {
+        producers = {m_kafka_producers[m_created.fetch_add(1) % m_kafka_producers.size()]};
+    }
+    return new KafkaSink(processor_name, producers, m_in_flight_budget, m_partition_counts, m_batch_size);
+}
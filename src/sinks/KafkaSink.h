@@ -0,0 +1,127 @@
+/**
+ * Sink producing to Kafka.
+ *
+ * Messages are grouped into per-(topic, partition) batches which are enqueued into librdkafka
+ * with a single rd_kafka_produce_batch() call each. Batches are spread over the sink's
+ * producers by (topic, partition). Without a partition count (no local partitioner, or an
+ * unknown topic) the partition is left to librdkafka and all batches of the topic go to the
+ * same producer.
+ **/
+#ifndef KAFKA_SINK_H
+#define KAFKA_SINK_H
+
+#include "Sink.h"
+#include "impl/InFlightBudget.h"
+#include <librdkafka/rdkafkacpp.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string_view>
+
+/**
+ * Message counts of a KafkaSink, updated by the delivery report callback. Outlives the sink
+ * for late reports.
+ **/
+struct KafkaDeliveryCounts
+{
+    // Handed over and not yet delivered or failed
+    std::atomic<size_t> in_flight = 0;
+    // Failed or dropped since the last take_failed()
+    std::atomic<size_t> failed = 0;
+};
+
+/**
+ * Opaque of every message enqueued by a KafkaSink. The delivery report callback acks the
+ * segment, updates the counts of the sink and deletes it.
+ **/
+struct KafkaDelivery
+{
+    std::shared_ptr<KafkaDeliveryCounts> counts;
+    CheckpointSegment *segment;
+};
+
+class KafkaSink : public Sink
+{
+private:
+    struct PendingMessage
+    {
+        std::string key;
+        std::vector<char> payload;
+        CheckpointSegment *segment;
+    };
+
+    /**
+     * Orders (topic, partition) pairs by std::string or std::string_view topics, so produce()
+     * can find a batch without copying the topic name.
+     **/
+    struct DestinationLess
+    {
+        using is_transparent = void;
+
+        template <typename A, typename B>
+        bool operator()(const A &a, const B &b) const
+        {
+            return std::make_pair(std::string_view(a.first), a.second) < std::make_pair(std::string_view(b.first), b.second);
+        }
+    };
+
+    const std::string m_name;
+    const std::vector<RdKafka::Producer *> m_kafka_producers;
+    InFlightBudget *m_in_flight_budget;
+    const std::map<std::string, int32_t> *m_partition_counts;
+    const size_t m_batch_size;
+
+    size_t m_batched = 0;
+    std::shared_ptr<KafkaDeliveryCounts> m_counts = std::make_shared<KafkaDeliveryCounts>();
+    // Batches are cleared and not erased after producing, so topic names are only copied once
+    std::map<std::pair<std::string, int32_t>, std::vector<PendingMessage>, DestinationLess> m_batches;
+    std::map<std::pair<size_t, std::string>, RdKafka::Topic *> m_topics;
+    // Producers this sink enqueued messages into, by index
+    std::vector<bool> m_used;
+
+    size_t producer_index(const std::string &topic_name, int32_t partition) const;
+    RdKafka::Topic *topic_handle(size_t producer_idx, const std::string &topic_name);
+    void produce_batches();
+
+public:
+    KafkaSink(std::string name, std::vector<RdKafka::Producer *> kafka_producers, InFlightBudget *in_flight_budget, const std::map<std::string, int32_t> *partition_counts, size_t batch_size);
+    KafkaSink(const KafkaSink &) = delete;
+    void operator=(const KafkaSink &) = delete;
+    ~KafkaSink() override;
+
+    void produce(const std::string &topic, std::string_view key, std::vector<char> &&payload, CheckpointSegment *segment) override;
+
+    /**
+     * Waits for the delivery reports of this sink's messages only, other sinks may share the
+     * producers.
+     **/
+    void flush() override;
+
+    /**
+     * Messages of this sink without a delivery report yet. The producers may be shared, so
+     * their queue lengths can't be used.
+     **/
+    size_t outstanding() const override;
+    size_t take_failed() override;
+};
+
+/**
+ * Shares the producers among the sinks according to the producer topology: every sink uses
+ * all producers, or with per_sink set each sink gets its own producer (round robin).
+ **/
+class KafkaSinkFactory : public SinkFactory
+{
+private:
+    const std::vector<RdKafka::Producer *> m_kafka_producers;
+    const bool m_per_sink;
+    InFlightBudget *m_in_flight_budget;
+    const std::map<std::string, int32_t> *m_partition_counts;
+    const size_t m_batch_size;
+    std::atomic<size_t> m_created = 0;
+
+public:
+    KafkaSinkFactory(std::vector<RdKafka::Producer *> kafka_producers, bool per_sink, InFlightBudget *in_flight_budget, const std::map<std::string, int32_t> *partition_counts, size_t batch_size);
+    Sink *create(const std::string &processor_name) override;
+};
+
+#endif
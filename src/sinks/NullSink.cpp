@@ -0,0 +1,28 @@
+#include "NullSink.h"
+
+void NullSink::produce(const std::string &, std::string_view, std::vector<char> &&, CheckpointSegment *segment)
+{
+    if (segment)
+    {
+        segment->ack(true);
+    }
+}
+
+void NullSink::flush()
+{
+}
+
+size_t NullSink::outstanding() const
+{
+    return 0;
+}
+
+size_t NullSink::take_failed()
+{
+    return 0;
+}
+
+Sink *NullSinkFactory::create(const std::string &)
+{
+    return new NullSink();
+}
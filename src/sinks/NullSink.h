@@ -0,0 +1,25 @@
+/**
+ * Sink discarding every message, for measuring the throughput of parsing, transforming and
+ * encoding without a broker. Messages count as durable as soon as they are handed over.
+ **/
+#ifndef NULL_SINK_H
+#define NULL_SINK_H
+
+#include "Sink.h"
+
+class NullSink : public Sink
+{
+public:
+    void produce(const std::string &topic, std::string_view key, std::vector<char> &&payload, CheckpointSegment *segment) override;
+    void flush() override;
+    size_t outstanding() const override;
+    size_t take_failed() override;
+};
+
+class NullSinkFactory : public SinkFactory
+{
+public:
+    Sink *create(const std::string &processor_name) override;
+};
+
+#endif
@@ -0,0 +1,100 @@
+#include "OcfSink.h"
+#include "logging/Logging.h"
+#include <algorithm>
+
+/* Size of the Confluent wire format header ([<magic byte> <schema id>]) in front of the datum */
+static constexpr size_t FRAMING_SIZE = 5;
+
+OcfSink::OcfSink(std::string name, std::string directory, const std::map<std::string, SchemaConfig> *schemas, OcfWriter::Codec codec, size_t block_size) : m_name(name), m_directory(directory), m_schemas(schemas), m_codec(codec), m_block_size(block_size), m_started(time(NULL))
+{
+}
+
+OcfSink::~OcfSink()
+{
+    // Files that were not flushed stay behind as <path>_tmp
+    ack(false);
+}
+
+void OcfSink::produce(const std::string &topic, std::string_view key, std::vector<char> &&payload, CheckpointSegment *segment)
+{
+    auto it = m_writers.find(topic);
+    if (it == m_writers.end())
+    {
+        std::string processor = m_name;
+        std::replace(processor.begin(), processor.end(), ' ', '_');
+        std::string path = m_directory + "/" + topic + "-" + processor + "-" + std::to_string(m_started) + "-" + std::to_string(m_file_count++) + ".avro";
+
+        it = m_writers.emplace(topic, std::make_unique<OcfWriter>(path, m_schemas->at(topic).schema.toJson(false), m_codec, m_block_size)).first;
+        LOG_DEBUG("Writing '" + path + "'", m_name);
+    }
+
+    it->second->append(payload.data() + FRAMING_SIZE, payload.size() - FRAMING_SIZE);
+    ++m_outstanding;
+
+    if (segment)
+    {
+        if (m_unacked.empty() || m_unacked.back().first != segment)
+        {
+            m_unacked.emplace_back(segment, 0);
+        }
+        ++m_unacked.back().second;
+    }
+}
+
+void OcfSink::flush()
+{
+    bool ok = true;
+    for (auto &[topic, writer] : m_writers)
+    {
+        try
+        {
+            writer->close();
+        }
+        catch (const std::exception &e)
+        {
+            Logging::ERROR(e.what(), m_name);
+            ok = false;
+        }
+    }
+    m_writers.clear();
+
+    ack(ok);
+    if (!ok)
+    {
+        m_failed += m_outstanding;
+    }
+    m_outstanding = 0;
+}
+
+size_t OcfSink::outstanding() const
+{
+    return m_outstanding;
+}
+
+size_t OcfSink::take_failed()
+{
+    size_t failed = m_failed;
+    m_failed = 0;
+    return failed;
+}
+
+void OcfSink::ack(bool written)
+{
+    for (auto &[segment, count] : m_unacked)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            segment->ack(written);
+        }
+    }
+    m_unacked.clear();
+}
+
+OcfSinkFactory::OcfSinkFactory(std::string directory, const std::map<std::string, SchemaConfig> *schemas, OcfWriter::Codec codec, size_t block_size) : m_directory(directory), m_schemas(schemas), m_codec(codec), m_block_size(block_size)
+{
+}
+
+Sink *OcfSinkFactory::create(const std::string &processor_name)
+{
+    return new OcfSink(processor_name, m_directory, m_schemas, m_codec, m_block_size);
+}
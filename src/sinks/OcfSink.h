@@ -0,0 +1,63 @@
+/**
+ * Sink writing Avro Object Container Files instead of producing to Kafka, e.g. for backfills.
+ *
+ * Every processor writes its own file per topic: <directory>/<topic>-<processor>-<start time>-<n>.avro.
+ * flush() completes the open files (once per input file), which makes their messages durable.
+ **/
+#ifndef OCF_SINK_H
+#define OCF_SINK_H
+
+#include "Sink.h"
+#include "OcfWriter.h"
+#include "config/SchemaConfig.h"
+#include <ctime>
+#include <map>
+#include <memory>
+
+class OcfSink : public Sink
+{
+private:
+    const std::string m_name;
+    const std::string m_directory;
+    const std::map<std::string, SchemaConfig> *m_schemas;
+    const OcfWriter::Codec m_codec;
+    const size_t m_block_size;
+
+    const time_t m_started;
+    size_t m_file_count = 0;
+    std::map<std::string, std::unique_ptr<OcfWriter>> m_writers;
+
+    // Messages written since the last flush(), by segment
+    std::vector<std::pair<CheckpointSegment *, size_t>> m_unacked;
+    size_t m_outstanding = 0;
+    // Messages of files that could not be completed since the last take_failed()
+    size_t m_failed = 0;
+
+    void ack(bool written);
+
+public:
+    OcfSink(std::string name, std::string directory, const std::map<std::string, SchemaConfig> *schemas, OcfWriter::Codec codec, size_t block_size);
+    OcfSink(const OcfSink &) = delete;
+    void operator=(const OcfSink &) = delete;
+    ~OcfSink() override;
+
+    void produce(const std::string &topic, std::string_view key, std::vector<char> &&payload, CheckpointSegment *segment) override;
+    void flush() override;
+    size_t outstanding() const override;
+    size_t take_failed() override;
+};
+
+class OcfSinkFactory : public SinkFactory
+{
+private:
+    const std::string m_directory;
+    const std::map<std::string, SchemaConfig> *m_schemas;
+    const OcfWriter::Codec m_codec;
+    const size_t m_block_size;
+
+public:
+    OcfSinkFactory(std::string directory, const std::map<std::string, SchemaConfig> *schemas, OcfWriter::Codec codec, size_t block_size);
+    Sink *create(const std::string &processor_name) override;
+};
+
+#endif
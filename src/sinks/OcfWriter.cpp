@@ -0,0 +1,198 @@
+#include "OcfWriter.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <unistd.h>
+#include <zlib.h>
+#include <zstd.h>
+
+OcfWriter::Codec OcfWriter::codec(const std::string &codec_name)
+{
+    if (!codec_name.compare("null"))
+    {
+        return Codec::NONE;
+    }
+    if (!codec_name.compare("deflate"))
+    {
+        return Codec::DEFLATE;
+    }
+    if (!codec_name.compare("zstandard"))
+    {
+        return Codec::ZSTANDARD;
+    }
+    throw std::invalid_argument("Unsupported avro codec '" + codec_name + "'. Valid codecs are: null, deflate, zstandard");
+}
+
+OcfWriter::OcfWriter(std::string path, const std::string &schema_json, Codec codec, size_t block_size) : m_path(path), m_codec(codec), m_block_size(block_size), m_file(fopen((path + "_tmp").c_str(), "wb"))
+{
+    if (!m_file)
+    {
+        throw std::runtime_error("Unable to create '" + m_path + "_tmp': " + strerror(errno));
+    }
+
+    std::random_device rd;
+    for (char &c : m_sync)
+    {
+        c = static_cast<char>(rd());
+    }
+
+    static const std::string codec_names[] = {"null", "deflate", "zstandard"};
+    const std::string &codec_name = codec_names[static_cast<int>(m_codec)];
+
+    // Header: magic, metadata map, sync marker
+    m_out = {'O', 'b', 'j', 1};
+    write_long(m_out, 2);
+    write_bytes(m_out, "avro.schema", 11);
+    write_bytes(m_out, schema_json.data(), schema_json.size());
+    write_bytes(m_out, "avro.codec", 10);
+    write_bytes(m_out, codec_name.data(), codec_name.size());
+    write_long(m_out, 0);
+    m_out.insert(m_out.end(), m_sync, m_sync + sizeof(m_sync));
+    write(m_out);
+
+    m_block.reserve(m_block_size + m_block_size / 4);
+}
+
+OcfWriter::~OcfWriter()
+{
+    if (m_file)
+    {
+        // Not closed: leave the incomplete file behind as <path>_tmp
+        fclose(m_file);
+    }
+}
+
+void OcfWriter::append(const char *datum, size_t len)
+{
+    m_block.insert(m_block.end(), datum, datum + len);
+    ++m_block_count;
+
+    if (m_block.size() >= m_block_size)
+    {
+        write_block();
+    }
+}
+
+void OcfWriter::close()
+{
+    write_block();
+
+    // The messages are acknowledged as durable once close() returns: sync the data before the rename
+    // and the directory entry after it
+    FILE *file = m_file;
+    m_file = nullptr;
+    bool synced = fflush(file) == 0 && fsync(fileno(file)) == 0;
+    if (fclose(file) != 0 || !synced)
+    {
+        throw std::runtime_error("Unable to write '" + m_path + "_tmp': " + strerror(errno));
+    }
+
+    if (rename((m_path + "_tmp").c_str(), m_path.c_str()) != 0)
+    {
+        throw std::runtime_error("Unable to rename '" + m_path + "_tmp': " + strerror(errno));
+    }
+
+    std::string directory = std::filesystem::path(m_path).parent_path().string();
+    int dir_fd = open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dir_fd < 0 || fsync(dir_fd) != 0)
+    {
+        int err = errno;
+        if (dir_fd >= 0)
+        {
+            ::close(dir_fd);
+        }
+        throw std::runtime_error("Unable to sync the directory of '" + m_path + "': " + strerror(err));
+    }
+    ::close(dir_fd);
+}
+
+void OcfWriter::write_long(std::vector<char> &out, int64_t value)
+{
+    // zig-zag encoded variable-length integer
+    uint64_t n = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    while (n & ~0x7fULL)
+    {
+        out.push_back(static_cast<char>((n & 0x7f) | 0x80));
+        n >>= 7;
+    }
+    out.push_back(static_cast<char>(n));
+}
+
+void OcfWriter::write_bytes(std::vector<char> &out, const char *data, size_t len)
+{
+    write_long(out, static_cast<int64_t>(len));
+    out.insert(out.end(), data, data + len);
+}
+
+void OcfWriter::write(const std::vector<char> &data)
+{
+    if (fwrite(data.data(), 1, data.size(), m_file) != data.size())
+    {
+        throw std::runtime_error("Unable to write '" + m_path + "_tmp': " + strerror(errno));
+    }
+}
+
+void OcfWriter::write_block()
+{
+    if (m_block_count == 0)
+    {
+        return;
+    }
+
+    const std::vector<char> *data = &m_block;
+    switch (m_codec)
+    {
+    case Codec::DEFLATE:
+    {
+        // Raw deflate data without zlib header and checksum
+        z_stream zs{};
+        if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            throw std::runtime_error("deflateInit2 failed");
+        }
+        m_compressed.resize(deflateBound(&zs, m_block.size()));
+        zs.next_in = reinterpret_cast<Bytef *>(m_block.data());
+        zs.avail_in = static_cast<uInt>(m_block.size());
+        zs.next_out = reinterpret_cast<Bytef *>(m_compressed.data());
+        zs.avail_out = static_cast<uInt>(m_compressed.size());
+        int ret = deflate(&zs, Z_FINISH);
+        m_compressed.resize(zs.total_out);
+        deflateEnd(&zs);
+        if (ret != Z_STREAM_END)
+        {
+            throw std::runtime_error("deflate failed");
+        }
+        data = &m_compressed;
+        break;
+    }
+    case Codec::ZSTANDARD:
+    {
+        m_compressed.resize(ZSTD_compressBound(m_block.size()));
+        size_t ret = ZSTD_compress(m_compressed.data(), m_compressed.size(), m_block.data(), m_block.size(), 3);
+        if (ZSTD_isError(ret))
+        {
+            throw std::runtime_error(std::string("zstd: ") + ZSTD_getErrorName(ret));
+        }
+        m_compressed.resize(ret);
+        data = &m_compressed;
+        break;
+    }
+    default:
+        break;
+    }
+
+    m_out.clear();
+    write_long(m_out, static_cast<int64_t>(m_block_count));
+    write_long(m_out, static_cast<int64_t>(data->size()));
+    write(m_out);
+    write(*data);
+
+    m_out.assign(m_sync, m_sync + sizeof(m_sync));
+    write(m_out);
+
+    m_block.clear();
+    m_block_count = 0;
+}
@@ -0,0 +1,61 @@
+/**
+ * Writer of Avro Object Container Files (https://avro.apache.org/docs/current/specification/#object-container-files).
+ *
+ * Takes records that are already Avro binary encoded and collects them into blocks of about
+ * block_size bytes, each compressed with the file's codec (null, deflate or zstandard).
+ * The file is written as <path>_tmp and renamed to path by close(), so readers never see a
+ * partial file. I/O errors are thrown as std::runtime_error.
+ **/
+#ifndef OCF_WRITER_H
+#define OCF_WRITER_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class OcfWriter
+{
+public:
+    enum class Codec
+    {
+        NONE,
+        DEFLATE,
+        ZSTANDARD
+    };
+
+    /**
+     * Codec by its Avro name. Throws std::invalid_argument for unsupported codecs.
+     **/
+    static Codec codec(const std::string &codec_name);
+
+    OcfWriter(std::string path, const std::string &schema_json, Codec codec, size_t block_size);
+    OcfWriter(const OcfWriter &) = delete;
+    void operator=(const OcfWriter &) = delete;
+    ~OcfWriter();
+
+    void append(const char *datum, size_t len);
+
+    /**
+     * Write the last block and publish the file under its final name.
+     **/
+    void close();
+
+private:
+    const std::string m_path;
+    const Codec m_codec;
+    const size_t m_block_size;
+    FILE *m_file;
+    char m_sync[16];
+
+    std::vector<char> m_block;
+    size_t m_block_count = 0;
+    std::vector<char> m_compressed;
+    std::vector<char> m_out;
+
+    static void write_long(std::vector<char> &out, int64_t value);
+    static void write_bytes(std::vector<char> &out, const char *data, size_t len);
+    void write(const std::vector<char> &data);
+    void write_block();
+};
+
+#endif
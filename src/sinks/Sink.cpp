@@ -0,0 +1,5 @@
+#include "Sink.h"
+
+Sink::~Sink(){};
+
+SinkFactory::~SinkFactory(){};
@@ -0,0 +1,56 @@
+/**
+ * Destination of the serialized messages of a CsvProcessor.
+ *
+ * A Sink is used by a single processor thread only. It is created by a SinkFactory, which
+ * is shared by all processors and owns whatever the sinks share (e.g. the Kafka producers).
+ **/
+#ifndef SINK_H
+#define SINK_H
+
+#include "impl/FileCheckpoint.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Sink
+{
+public:
+    virtual ~Sink();
+
+    /**
+     * Hand over a message. payload is Avro binary in the Confluent wire format
+     * ([<magic byte> <schema id> <avro datum>]). If segment is set, the caller has added the
+     * message to it and the sink acks it once the message is durable (or failed). If produce()
+     * throws, the sink did not take the message and the caller acks it.
+     **/
+    virtual void produce(const std::string &topic, std::string_view key, std::vector<char> &&payload, CheckpointSegment *segment) = 0;
+
+    /**
+     * Block until all messages handed over so far are durable or failed.
+     **/
+    virtual void flush() = 0;
+
+    /**
+     * Messages handed over but not yet durable or failed.
+     **/
+    virtual size_t outstanding() const = 0;
+
+    /**
+     * Messages that failed (were not delivered, or dropped) since the previous call. Streams and
+     * socket batches check it after every flush(), files are covered by their checkpoint.
+     **/
+    virtual size_t take_failed() = 0;
+};
+
+class SinkFactory
+{
+public:
+    virtual ~SinkFactory();
+
+    /**
+     * Create the sink of the processor with the given name. Called on the processor's thread.
+     **/
+    virtual Sink *create(const std::string &processor_name) = 0;
+};
+
+#endif
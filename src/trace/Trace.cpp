@@ -0,0 +1,158 @@
+#include "Trace.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+    // Fields are atomics so that dump() can read a buffer while its thread writes to it
+    struct Event
+    {
+        std::atomic<const char *> name;
+        std::atomic<int64_t> start_ns;
+        std::atomic<int64_t> duration_ns;
+    };
+
+    struct ThreadBuffer
+    {
+        size_t tid;
+        std::string thread_name;
+        size_t capacity;
+        std::unique_ptr<Event[]> events;
+        std::atomic<uint64_t> head = 0; // index of the next event
+    };
+
+    std::mutex buffers_mutex;
+    // Never freed: spans of finished threads stay in the trace
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    size_t events_per_thread = 0;
+    std::string trace_path;
+
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    thread_local std::string thread_name;
+    thread_local ThreadBuffer *thread_buffer = nullptr;
+
+    ThreadBuffer *create_thread_buffer()
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->tid = buffers.size() + 1;
+        buffer->thread_name = thread_name.empty() ? "thread " + std::to_string(buffer->tid) : thread_name;
+        buffer->capacity = events_per_thread;
+        buffer->events = std::make_unique<Event[]>(buffer->capacity);
+        buffers.push_back(std::move(buffer));
+        return buffers.back().get();
+    }
+
+    void append_string(std::string &out, const std::string &value)
+    {
+        out += '"';
+        for (char c : value)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out += '\\';
+            }
+            out += static_cast<unsigned char>(c) < 0x20 ? ' ' : c;
+        }
+        out += '"';
+    }
+} // end namespace
+
+int64_t Trace::now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Trace::record(const char *name, int64_t start_ns, int64_t duration_ns)
+{
+    ThreadBuffer *buffer = thread_buffer;
+    if (!buffer)
+    {
+        buffer = thread_buffer = create_thread_buffer();
+    }
+
+    uint64_t index = buffer->head.load(std::memory_order_relaxed);
+    Event &event = buffer->events[index % buffer->capacity];
+    event.name.store(name, std::memory_order_relaxed);
+    event.start_ns.store(start_ns, std::memory_order_relaxed);
+    event.duration_ns.store(duration_ns, std::memory_order_relaxed);
+    buffer->head.store(index + 1, std::memory_order_release);
+}
+
+void Trace::configure(size_t events, const std::string &path)
+{
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        events_per_thread = events > 0 ? events : 1;
+        trace_path = path;
+    }
+    enabled.store(true);
+}
+
+void Trace::set_thread_name(const std::string &name)
+{
+    thread_name = name;
+}
+
+bool Trace::dump()
+{
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    if (trace_path.empty())
+    {
+        return false;
+    }
+
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    const std::string pid = std::to_string(getpid());
+    bool first = true;
+    char buffer[128];
+    for (const auto &b : buffers)
+    {
+        out += first ? "" : ",";
+        first = false;
+        out += "\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" + pid + ",\"tid\":" + std::to_string(b->tid) + ",\"args\":{\"name\":";
+        append_string(out, b->thread_name);
+        out += "}}";
+
+        uint64_t head = b->head.load(std::memory_order_acquire);
+        uint64_t from = head > b->capacity ? head - b->capacity : 0;
+        std::vector<std::tuple<const char *, int64_t, int64_t>> events;
+        events.reserve(head - from);
+        for (uint64_t i = from; i < head; ++i)
+        {
+            const Event &event = b->events[i % b->capacity];
+            events.emplace_back(event.name.load(std::memory_order_relaxed), event.start_ns.load(std::memory_order_relaxed), event.duration_ns.load(std::memory_order_relaxed));
+        }
+
+        // Skip the events the thread may have overwritten while they were copied
+        uint64_t now_head = b->head.load(std::memory_order_acquire);
+        uint64_t valid_from = now_head >= b->capacity ? now_head - b->capacity + 1 : 0;
+        for (uint64_t i = std::max(from, valid_from); i < head; ++i)
+        {
+            const auto &[name, start_ns, duration_ns] = events[i - from];
+            snprintf(buffer, sizeof(buffer), ",\"ts\":%.3f,\"dur\":%.3f}", start_ns / 1000.0, duration_ns / 1000.0);
+            out += ",\n{\"ph\":\"X\",\"name\":";
+            append_string(out, name);
+            out += ",\"pid\":" + pid + ",\"tid\":" + std::to_string(b->tid) + buffer;
+        }
+    }
+    out += "\n]}\n";
+
+    std::string tmp_path = trace_path + "_tmp";
+    FILE *file = fopen(tmp_path.c_str(), "w");
+    if (!file)
+    {
+        return false;
+    }
+    bool ok = fwrite(out.data(), 1, out.size(), file) == out.size();
+    ok = fclose(file) == 0 && ok;
+    return ok && rename(tmp_path.c_str(), trace_path.c_str()) == 0;
+}
@@ -0,0 +1,80 @@
+/**
+ * Scoped tracing spans, written as a Chrome trace (chrome://tracing, https://ui.perfetto.dev).
+ *
+ * Every thread records its spans into its own ring buffer, which keeps the last
+ * events_per_thread spans. Recording takes no lock; while tracing is disabled a span costs a
+ * single atomic load. dump() writes the buffered spans of all threads, e.g. on SIGUSR1.
+ *
+ *   {
+ *     TRACE_SPAN("serialize");
+ *     ...
+ *   }
+ *
+ * Span names must be string literals (only the pointer is recorded).
+ **/
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace Trace
+{
+    inline std::atomic<bool> enabled = false;
+
+    int64_t now_ns();
+
+    void record(const char *name, int64_t start_ns, int64_t duration_ns);
+
+    /**
+     * Allocate ring buffers of events_per_thread spans, set the file dump() writes and
+     * start recording.
+     **/
+    void configure(size_t events_per_thread, const std::string &path);
+
+    /**
+     * Name of the calling thread in the trace.
+     **/
+    void set_thread_name(const std::string &name);
+
+    /**
+     * Write the recorded spans of all threads to the configured file (atomically, through a
+     * temporary file and rename()). Returns false if tracing is not configured or the file
+     * can't be written.
+     **/
+    bool dump();
+
+    class Span
+    {
+    private:
+        const char *m_name;
+        int64_t m_start;
+
+    public:
+        Span(const char *name) : m_name(enabled.load(std::memory_order_relaxed) ? name : nullptr)
+        {
+            if (m_name)
+            {
+                m_start = now_ns();
+            }
+        }
+
+        ~Span()
+        {
+            if (m_name)
+            {
+                record(m_name, m_start, now_ns() - m_start);
+            }
+        }
+
+        Span(const Span &) = delete;
+        void operator=(const Span &) = delete;
+    };
+} // end namespace
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SPAN(span_name) Trace::Span TRACE_CONCAT(trace_span_, __LINE__)(span_name)
+
+#endif
@@ -13,6 +13,6 @@ void BaseTransformer::Operation(CSVRow &row) const
 {
     if (!row[m_column].empty())
     {
-        row[m_column] = "BASE " + row[m_column];
+        row[m_column].insert(0, "BASE ");
     }
 }
\ No newline at end of file
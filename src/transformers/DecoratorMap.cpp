@@ -12,7 +12,7 @@ void DecoratorMap::Operation(CSVRow &row) const
 
     if (!row[m_column].empty())
     {
-        std::map<std::string, std::string>::const_iterator it = lookup.find(row[m_column]);
+        auto it = lookup.find(std::string_view(row[m_column]));
         if (it != lookup.cend())
         {
             row[m_column] = it->second;
@@ -22,7 +22,7 @@ public:
 
 private:
     REGISTER_DEC_TYPE(DecoratorMap);
-    std::map<std::string, std::string> lookup;
+    std::map<std::string, std::string, std::less<>> lookup;
 };
 
 #endif
\ No newline at end of file
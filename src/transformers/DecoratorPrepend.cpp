@@ -12,7 +12,7 @@ void DecoratorPrepend::Operation(CSVRow &row) const
 
     if (!row[m_column].empty() && !row[m_from_column].empty())
     {
-        row[m_column] = row[m_from_column] + row[m_column];
+        row[m_column].insert(0, row[m_from_column]);
     }
 }
 
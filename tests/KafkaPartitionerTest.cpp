@@ -0,0 +1,49 @@
+#include "Base.hh"
+
+#include "impl/KafkaPartitioner.h"
+
+#include <string>
+
+/**
+ * Expected hashes are the results of org.apache.kafka.common.utils.Utils.murmur2() and
+ * the partitions those of the Java client's default partitioner
+ * (Utils.toPositive(murmur2(key)) % partition_cnt) for the UTF-8 bytes of each key.
+ **/
+struct JavaVector
+{
+    std::string key;
+    int32_t murmur2;
+    int32_t partition_3;
+    int32_t partition_12;
+    int32_t partition_100;
+};
+
+void testKafkaPartitionerJavaCompatibility()
+{
+    ALEPH_TEST_BEGIN("KafkaPartitioner Java compatibility");
+    const JavaVector vectors[] = {
+        // Empty key
+        {"", 275646681, 0, 9, 81},
+        // Key lengths with 1, 2 and 3 tail bytes
+        {"a", -1563381124, 1, 4, 24},
+        {"abcde", 461995741, 1, 1, 41},
+        {"21", -973932308, 0, 0, 40},
+        {"foobar", -790332482, 0, 6, 66},
+        {"abc", 479470107, 0, 3, 7},
+        // No tail bytes
+        {"a-little-bit-long-string", -985981536, 2, 8, 12},
+        // Multi-byte UTF-8: bytes >= 0x80 in the 4-byte blocks (12 bytes) and in the tail (15 bytes)
+        {"\xc3\xbc" "berm\xc3\xa4\xc3\x9fig", -733797639, 2, 5, 9},
+        {"\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\xe3\x82\xad\xe3\x83\xbc", 1445825182, 1, 10, 82},
+    };
+
+    for (const JavaVector &v : vectors)
+    {
+        ALEPH_ASSERT_EQUAL(KafkaPartitioner::murmur2(v.key), v.murmur2);
+        ALEPH_ASSERT_EQUAL(KafkaPartitioner::partition(v.key, 1), 0);
+        ALEPH_ASSERT_EQUAL(KafkaPartitioner::partition(v.key, 3), v.partition_3);
+        ALEPH_ASSERT_EQUAL(KafkaPartitioner::partition(v.key, 12), v.partition_12);
+        ALEPH_ASSERT_EQUAL(KafkaPartitioner::partition(v.key, 100), v.partition_100);
+    }
+    ALEPH_TEST_END();
+}
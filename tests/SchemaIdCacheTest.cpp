@@ -0,0 +1,41 @@
+#include "Base.hh"
+
+#include "impl/SchemaIdCache.h"
+
+#include <cstdio>
+
+static const std::string CACHE_PATH = "schema_id_cache_test.txt";
+
+void testSchemaIdCacheRefresh()
+{
+    ALEPH_TEST_BEGIN("SchemaIdCache refresh");
+    std::remove(CACHE_PATH.c_str());
+    {
+        SchemaIdCache cache(CACHE_PATH);
+        cache.store("a-value", 1, 7);
+        cache.store("b-value", 2, 9);
+        ALEPH_ASSERT_THROW(cache.save());
+    }
+
+    // Stub registry: a different id for a-value, unavailable for b-value
+    auto a_id = std::make_shared<std::atomic<int32_t>>(7);
+    auto b_id = std::make_shared<std::atomic<int32_t>>(9);
+    {
+        SchemaIdCache cache(CACHE_PATH);
+        ALEPH_ASSERT_EQUAL(cache.lookup("a-value", 1), 7);
+        cache.refresh_async({{"a-value", 1, "{}", a_id}, {"b-value", 2, "{}", b_id}}, [](const SchemaIdCache::Entry &entry)
+                            { return entry.subject == "a-value" ? 8 : -1; });
+        cache.join();
+
+        // The stale id is swapped in use and in the cache, the unresolved one is kept
+        ALEPH_ASSERT_EQUAL(a_id->load(), 8);
+        ALEPH_ASSERT_EQUAL(b_id->load(), 9);
+        ALEPH_ASSERT_EQUAL(cache.lookup("a-value", 1), 8);
+        ALEPH_ASSERT_EQUAL(cache.lookup("b-value", 2), 9);
+    }
+
+    SchemaIdCache cache(CACHE_PATH);
+    ALEPH_ASSERT_EQUAL(cache.lookup("a-value", 1), 8);
+    std::remove(CACHE_PATH.c_str());
+    ALEPH_TEST_END();
+}
@@ -1,5 +1,8 @@
 #include "Base.hh"
 
+void testSchemaIdCacheRefresh();
+void testKafkaPartitionerJavaCompatibility();
+
 double foo = 2.0;
 double bar = 1.0;
 
@@ -22,4 +25,6 @@ int main(int, char **)
 {
     testBasic();
     testAdvanced();
+    testSchemaIdCacheRefresh();
+    testKafkaPartitionerJavaCompatibility();
 }